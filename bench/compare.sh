@@ -0,0 +1,54 @@
+#!/bin/bash
+#
+# Alexander Kim, kima4
+# CS344 - Assignment 3
+#
+# Compares the startup time and command lines per second of each smallsh build that exists in the
+# current directory (smallsh, smallsh-release, smallsh-static, smallsh-pgo), using the
+# workloads from workload.sh. Run with "make bench" to build every variant first.
+#
+# Usage: compare.sh [COUNT] [STARTS]
+#	COUNT	workload size passed to workload.sh, 2000 by default
+#	STARTS	number of times each shell is started to time startup, 500 by default
+
+dir=$(dirname "$0")
+count=${1:-2000}
+starts=${2:-500}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+declare -A lines
+for w in parse spawn reap; do
+	"$dir/workload.sh" $w "$count" > "$tmp/$w"
+	lines[$w]=$(wc -l < "$tmp/$w")
+done
+
+# microseconds since the epoch
+now() {
+	echo $(( $(date +%s%N) / 1000 ))
+}
+
+# runs a workload through a shell and prints the lines handled per second
+rate() {
+	local start end
+	start=$(now)
+	"$1" < "$tmp/$2" > /dev/null 2>&1
+	end=$(now)
+	echo $(( ${lines[$2]} * 1000000 / (end - start + 1) ))
+}
+
+printf "%-16s %10s %12s %12s %12s %12s\n" "build" "size" "startup us" "parse/s" "spawn/s" "reap/s"
+for bin in smallsh smallsh-release smallsh-static smallsh-pgo; do
+	if [ ! -x "./$bin" ]; then
+		continue
+	fi
+
+	start=$(now)
+	for ((i = 0; i < starts; i++)); do
+		"./$bin" < /dev/null > /dev/null
+	done
+	end=$(now)
+
+	printf "%-16s %10d %12d %12d %12d %12d\n" "$bin" "$(stat -c %s "./$bin")" \
+		$(( (end - start) / starts )) "$(rate "./$bin" parse)" "$(rate "./$bin" spawn)" "$(rate "./$bin" reap)"
+done
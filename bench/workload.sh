@@ -0,0 +1,51 @@
+#!/bin/bash
+#
+# Alexander Kim, kima4
+# CS344 - Assignment 3
+#
+# Prints a benchmark workload for smallsh to stdout, to be piped into the shell. Used by the
+# makefile to train the PGO build and by compare.sh to measure each build.
+#
+# Usage: workload.sh parse|spawn|reap|train [COUNT]
+#	parse	comments, blank lines, $$ expansion, redirections and built in commands, no children
+#	spawn	short foreground commands, one fork and exec each
+#	reap	short background commands, reaped between prompts
+#	train	all of the above, for profile guided optimization
+
+count=${2:-2000}
+
+parse() {
+	for ((i = 0; i < count; i++)); do
+		echo "# comment line $i with \$\$ and > redirections < that are ignored &"
+		echo ""
+		echo "cd . > /dev/null"
+		echo "status > /dev/null"
+		echo "cd ./ < /dev/null >> /dev/null"
+		echo "cd \$\$/.. a b c d e f g h i j k l m n o p > /dev/null"
+	done
+}
+
+spawn() {
+	for ((i = 0; i < count; i++)); do
+		echo "true"
+		echo "true arg\$\$ < /dev/null > /dev/null"
+	done
+}
+
+reap() {
+	for ((i = 0; i < count; i++)); do
+		echo "true &"
+		echo "status > /dev/null"
+	done
+	echo "sleep 0.1"
+	echo "status > /dev/null"
+}
+
+case "$1" in
+	parse) parse ;;
+	spawn) spawn ;;
+	reap) reap ;;
+	train) count=${2:-500}; parse; spawn; reap ;;
+	*) echo "usage: $0 parse|spawn|reap|train [COUNT]" >&2; exit 1 ;;
+esac
+echo "exit"
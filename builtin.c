@@ -0,0 +1,250 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for the registry of built in commands and the commands themselves.
+* Commands compiled into the shell live in a perfect hash table made at build time by mkbuiltins,
+* and commands loaded from shared objects with "enable -f" live in a small chained hash table.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include "builtin.h"
+#include "builtin_table.h"
+#include "vars.h"
+
+
+/*----------------------------------------------------------------------
+*
+*  struct loaded
+* -------------
+*  Contains a command loaded from a shared object, as a link in one of
+*  the chains of the loaded command hash table.
+*
+* -------------
+*
+*  entry: a builtin struct for the command
+*
+*  handle: a pointer (void*) from dlopen() for the shared object
+*
+*  next: a pointer to the next loaded struct in the same bucket
+*
+*---------------------------------------------------------------------*/
+struct loaded {
+	struct builtin entry;
+	void* handle;
+	struct loaded* next;
+};
+
+
+struct loaded* loadedTable[LOADED_SLOTS]; // commands loaded with enable -f
+
+
+/*----------------------------------------------------------------------
+*
+*  findBuiltin
+* -------------
+*  Looks up a command name in the registry. Commands compiled into the
+*  shell take one hash and one string comparison to find.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name of the command
+*
+*  Returns a pointer to the builtin struct of the command, or NULL if
+*  it is not a built in command.
+*
+*---------------------------------------------------------------------*/
+struct builtin* findBuiltin(char* name) {
+	struct builtin* entry = &builtinTable[hashName(name, BUILTIN_SEED) & (BUILTIN_SLOTS - 1)];
+	struct loaded* curr;
+
+	if (entry->name != NULL && strcmp(entry->name, name) == 0) {
+		return entry;
+	}
+
+	for (curr = loadedTable[hashName(name, 0) % LOADED_SLOTS]; curr != NULL; curr = curr->next) {
+		if (strcmp(curr->entry.name, name) == 0) {
+			return &curr->entry;
+		}
+	}
+	return NULL;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInExit
+* -------------
+*  Code for the built in exit command for the shell.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0, but sets quit so the shell exits.
+*
+*---------------------------------------------------------------------*/
+int builtInExit(int argc, char* argv[], struct builtinIO* io) {
+	io->quit = 1;
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCD
+* -------------
+*  Code for the built in change directory command for the shell.
+*
+*  Fulfills requirement 4 of the assignment, in conjunction with
+*  getCommand(), by providing a built in cd command for the shell.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h, the
+*			second argument can contain an address
+*
+*  Changes directory to the specified directory or the home directory
+*  if one is not given. Returns the exit signal of chdir - currently
+*  unused.
+*
+*---------------------------------------------------------------------*/
+int builtInCD(int argc, char* argv[], struct builtinIO* io) {
+	char* newDir;
+	int exitSig;
+
+	if (argv[1] == NULL) {
+		newDir = varGet("HOME", 4); // the shell variable, which can be changed
+	}
+	else {
+		newDir = argv[1];
+	}
+
+	exitSig = chdir(newDir);
+
+	return exitSig;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInStatus
+* -------------
+*  Code for the built in status command for the shell.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Prints the exit status or terminating signal of the last foreground
+*  command. Returns 0.
+*
+*---------------------------------------------------------------------*/
+int builtInStatus(int argc, char* argv[], struct builtinIO* io) {
+	dprintf(io->out, "%s\n", io->status);
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInEnable
+* -------------
+*  Code for the built in enable command, which manages loaded
+*  commands:
+*		enable					lists every built in command
+*		enable -f FILE NAME		loads command NAME from shared object FILE
+*		enable -n NAME			unloads command NAME
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if successful, returns 1 and prints a message with the
+*  error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInEnable(int argc, char* argv[], struct builtinIO* io) {
+	struct loaded** link;
+	struct loaded* curr;
+	char symbol[MAX_LEN];
+	int* abi;
+	int i;
+
+	if (argc == 1) { // list everything
+		for (i = 0; i < BUILTIN_SLOTS; i++) {
+			if (builtinTable[i].name != NULL) {
+				dprintf(io->out, "enable %s\n", builtinTable[i].name);
+			}
+		}
+		for (i = 0; i < LOADED_SLOTS; i++) {
+			for (curr = loadedTable[i]; curr != NULL; curr = curr->next) {
+				dprintf(io->out, "enable -f %s\n", curr->entry.name);
+			}
+		}
+		return 0;
+	}
+
+	if (argc == 3 && strcmp(argv[1], "-n") == 0) { // unload
+		for (link = &loadedTable[hashName(argv[2], 0) % LOADED_SLOTS]; *link != NULL; link = &(*link)->next) {
+			if (strcmp((*link)->entry.name, argv[2]) == 0) {
+				curr = *link;
+				*link = curr->next;
+				dlclose(curr->handle);
+				free(curr->entry.name);
+				free(curr);
+				return 0;
+			}
+		}
+		dprintf(io->err, "enable: %s is not a loaded command\n", argv[2]);
+		return 1;
+	}
+
+	if (argc != 4 || strcmp(argv[1], "-f") != 0) {
+		dprintf(io->err, "usage: enable [-f FILE NAME] [-n NAME]\n");
+		return 1;
+	}
+
+	if (findBuiltin(argv[3]) != NULL) {
+		dprintf(io->err, "enable: %s is already a built in command\n", argv[3]);
+		return 1;
+	}
+
+	curr = malloc(sizeof(struct loaded));
+	curr->handle = dlopen(argv[2], RTLD_NOW | RTLD_LOCAL);
+	if (curr->handle == NULL) {
+		dprintf(io->err, "enable: %s\n", dlerror());
+		free(curr);
+		return 1;
+	}
+
+	abi = dlsym(curr->handle, BUILTIN_PREFIX "abi");
+	if (abi != NULL && *abi != BUILTIN_ABI) {
+		dprintf(io->err, "enable: %s was built for ABI %d, not %d\n", argv[2], *abi, BUILTIN_ABI);
+		dlclose(curr->handle);
+		free(curr);
+		return 1;
+	}
+
+	snprintf(symbol, MAX_LEN, "%s%s", BUILTIN_PREFIX, argv[3]);
+	*(void**)&curr->entry.func = dlsym(curr->handle, symbol); // avoids the object to function pointer warning
+	if (curr->entry.func == NULL) {
+		dprintf(io->err, "enable: %s has no %s\n", argv[2], symbol);
+		dlclose(curr->handle);
+		free(curr);
+		return 1;
+	}
+
+	curr->entry.name = strdup(argv[3]);
+	curr->entry.setsStatus = 1;
+	link = &loadedTable[hashName(argv[3], 0) % LOADED_SLOTS];
+	curr->next = *link;
+	*link = curr;
+
+	return 0;
+}
@@ -0,0 +1,337 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for the registry of built in commands. Commands compiled
+* into the shell are found with a perfect hash table made at build time from builtins.def, and
+* more can be loaded from shared objects at run time with "enable -f".
+*
+* Loadable builtin ABI (version BUILTIN_ABI):
+*	A shared object provides a command NAME by exporting a function
+*		int smallsh_builtin_NAME(int argc, char* argv[], struct builtinIO* io);
+*	and may export "int smallsh_builtin_abi = BUILTIN_ABI;" to be checked when it is loaded.
+*	argv is NULL terminated with argv[0] being NAME. The command must read from io->in and
+*	write to io->out and io->err instead of stdin, stdout and stderr, which already have any
+*	redirections of the command line applied, and must not close them. The return value is the
+*	exit value, which the shell reports through status just like an external command's.
+*/
+
+#ifndef BUILTIN_H
+#define BUILTIN_H
+
+#include "command.h"
+
+
+#define BUILTIN_ABI 1 // version of struct builtinIO and the function signature
+#define BUILTIN_PREFIX "smallsh_builtin_" // loaded functions are named the prefix followed by the command
+#define LOADED_SLOTS 64 // buckets in the hash table of loaded commands
+
+
+/*----------------------------------------------------------------------
+*
+*  struct builtinIO
+* -------------
+*  Contains everything a built in command gets from the shell besides
+*  its arguments.
+*
+* -------------
+*
+*  in: an int that is the file descriptor to read input from
+*
+*  out: an int that is the file descriptor to write output to
+*
+*  err: an int that is the file descriptor to write errors to
+*
+*  status: a string (char*) of length MAX_LEN that contains the status
+*			of the last foreground command
+*
+*  quit: an int that a command sets to 1 to make the shell exit
+*
+*---------------------------------------------------------------------*/
+struct builtinIO {
+	int in;
+	int out;
+	int err;
+	char* status;
+	int quit;
+};
+
+
+typedef int (*builtinFunc)(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  struct builtin
+* -------------
+*  Contains one entry in the registry of built in commands.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name of the command
+*
+*  func: a builtinFunc that runs the command
+*
+*  setsStatus: an int, 1 if the return value of the command becomes
+*			the shell's status like an external command's, 0 for
+*			commands such as cd that leave status alone
+*
+*---------------------------------------------------------------------*/
+struct builtin {
+	char* name;
+	builtinFunc func;
+	int setsStatus;
+};
+
+
+/*----------------------------------------------------------------------
+*
+*  hashName
+* -------------
+*  Hashes a command name with FNV-1a, mixed with a seed. Shared by the
+*  shell and mkbuiltins so both agree on where each name goes.
+*
+* -------------
+*
+*  name: a string (const char*) that contains the name to hash
+*
+*  seed: an unsigned int that changes the result of the hash
+*
+*  Returns the hash as an unsigned int.
+*
+*---------------------------------------------------------------------*/
+static inline unsigned int hashName(const char* name, unsigned int seed) {
+	unsigned int hash = 2166136261u ^ seed;
+	while (*name != '\0') {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash ^ (hash >> 15);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  findBuiltin
+* -------------
+*  Looks up a command name in the registry. Commands compiled into the
+*  shell take one hash and one string comparison to find.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name of the command
+*
+*  Returns a pointer to the builtin struct of the command, or NULL if
+*  it is not a built in command.
+*
+*---------------------------------------------------------------------*/
+struct builtin* findBuiltin(char* name);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInExit
+* -------------
+*  Code for the built in exit command for the shell.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0, but sets quit so the shell exits.
+*
+*---------------------------------------------------------------------*/
+int builtInExit(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCD
+* -------------
+*  Code for the built in change directory command for the shell.
+*
+*  Fulfills requirement 4 of the assignment, in conjunction with
+*  getCommand(), by providing a built in cd command for the shell.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above, the second
+*			argument can contain an address
+*
+*  Changes directory to the specified directory or the home directory
+*  if one is not given. Returns the exit signal of chdir - currently
+*  unused.
+*
+*---------------------------------------------------------------------*/
+int builtInCD(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInStatus
+* -------------
+*  Code for the built in status command for the shell.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Prints the exit status or terminating signal of the last foreground
+*  command. Returns 0.
+*
+*---------------------------------------------------------------------*/
+int builtInStatus(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInEnable
+* -------------
+*  Code for the built in enable command, which manages loaded
+*  commands:
+*		enable					lists every built in command
+*		enable -f FILE NAME		loads command NAME from shared object FILE
+*		enable -n NAME			unloads command NAME
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if successful, returns 1 and prints a message with the
+*  error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInEnable(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCoproc
+* -------------
+*  Code for the built in coproc command, "coproc NAME cmd [args]",
+*  which starts cmd as a coprocess in the background. Defined in
+*  coproc.c along with the other coprocess commands.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if the coprocess was started, returns 1 and prints a
+*  message with the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInCoproc(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCowrite
+* -------------
+*  Code for the built in cowrite command, "cowrite NAME [words]", which
+*  sends the words to a coprocess as one line.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if the line was sent, returns 1 and prints a message with
+*  the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInCowrite(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCoread
+* -------------
+*  Code for the built in coread command, "coread [-t SECONDS] NAME",
+*  which prints the next line from a coprocess.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if a line was printed, returns 1 if the coprocess ended
+*  its output or nothing came before the timeout.
+*
+*---------------------------------------------------------------------*/
+int builtInCoread(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCoclose
+* -------------
+*  Code for the built in coclose command, "coclose NAME", which closes
+*  the input of a coprocess so it sees the end of its input.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if successful, returns 1 and prints a message with the
+*  error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInCoclose(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInExport
+* -------------
+*  Code for the built in export command, "export [NAME[=value]...]",
+*  which exports variables, setting them first if a value is given.
+*  With no arguments it lists the exported variables. Defined in
+*  vars.c along with unset.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if successful, returns 1 and prints a message if a name
+*  is not valid.
+*
+*---------------------------------------------------------------------*/
+int builtInExport(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInUnset
+* -------------
+*  Code for the built in unset command, "unset NAME...", which removes
+*  variables.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if successful, returns 1 and prints a message if a name
+*  is not valid.
+*
+*---------------------------------------------------------------------*/
+int builtInUnset(int argc, char* argv[], struct builtinIO* io);
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInDag
+* -------------
+*  Code for the built in dag command, "dag [-j JOBS] [FILE]", which runs
+*  a graph of commands in dependency order, at most JOBS at once, and
+*  reports the critical path. Defined in dag.c, see dag.h for the
+*  format of the graph.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI above
+*
+*  Returns 0 if every target is made or up to date, returns 1 and
+*  prints a message otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInDag(int argc, char* argv[], struct builtinIO* io);
+
+#endif
@@ -15,6 +15,10 @@
 #include <unistd.h>
 
 #include "command.h"
+#include "vars.h"
+
+
+pid_t shellPid = 0;
 
 
 /*----------------------------------------------------------------------
@@ -40,14 +44,49 @@ void freeCommand(struct command* toFree) {
 	if (toFree->input != NULL) {
 		free(toFree->input);
 	}
-	if (toFree->output != NULL) {
-		free(toFree->output);
+	if (toFree->hereDelim != NULL) {
+		free(toFree->hereDelim);
+	}
+	if (toFree->hereBody != NULL) {
+		free(toFree->hereBody);
+	}
+	for (i = 0; i < toFree->outNum; i++) {
+		free(toFree->output[i]);
+	}
+	if (toFree->errOutput != NULL) {
+		free(toFree->errOutput);
+	}
+	for (i = 0; i < toFree->substNum; i++) {
+		free(toFree->subst[i]);
+	}
+	for (i = 0; i < toFree->assignNum; i++) {
+		free(toFree->assign[i]);
 	}
 	free(toFree);
 }
 
 
 
+/*----------------------------------------------------------------------
+*
+*  isAssignment
+* -------------
+*  Checks if a command line only sets shell variables, NAME=value words
+*  with no command name and no redirections.
+*
+* -------------
+*
+*  c: a command struct that has been parsed
+*
+*  Returns 1 if it only sets variables, 0 otherwise.
+*
+*---------------------------------------------------------------------*/
+int isAssignment(struct command* c) {
+	return c->name[0] == '\0' && c->assignNum > 0 && c->input == NULL && c->hereBody == NULL && c->outNum == 0
+		&& c->errOutput == NULL && !c->errToOut && c->substNum == 0;
+}
+
+
 /*----------------------------------------------------------------------
 *
 *  printCommand
@@ -76,7 +115,27 @@ void printCommand(struct command* toPrint) {
 
 	printf("INPUT FILE: %s\n\n", toPrint->input);
 
-	printf("OUTPUT FILE: %s\n\n", toPrint->output);
+	printf("HERE-DOCUMENT:\n%s\n", toPrint->hereBody);
+
+	printf("OUTPUT FILES:\n");
+	for (i = 0; i < toPrint->outNum; i++) {
+		printf("|  %s%s\n", toPrint->output[i], toPrint->append[i] ? " (append)" : "");
+	}
+	printf("\n");
+
+	printf("ERROR OUTPUT: %s%s\n\n", toPrint->errToOut ? "(same as output)" : toPrint->errOutput, toPrint->errAppend ? " (append)" : "");
+
+	printf("SUBSTITUTIONS:\n");
+	for (i = 0; i < toPrint->substNum; i++) {
+		printf("|  %s%s(%s) as argument %d\n", toPrint->substOut[i] ? ">" : "<", toPrint->substZip[i] ? "z" : "", toPrint->subst[i], toPrint->substArg[i]);
+	}
+	printf("\n");
+
+	printf("ASSIGNMENTS:\n");
+	for (i = 0; i < toPrint->assignNum; i++) {
+		printf("|  %s\n", toPrint->assign[i]);
+	}
+	printf("\n");
 
 	printf("BACKGROUND: ");
 	if (toPrint->background == 1) {
@@ -110,6 +169,20 @@ void printCommand(struct command* toPrint) {
 *		2 - symbol declaring the next argument gives an input file
 *		3 - symbol declaring the next argument gives an output file
 *		4 - ampersand, declares the process runs in the background
+*		5 - symbol declaring the next argument gives an output file
+*			that is to be appended to
+*		6 - symbol declaring the next argument ends a here-document
+*		7 - symbol declaring the next argument is a here-string
+*		8 - symbol declaring the next argument gives an error output
+*			file
+*		9 - same as 8, but the file is appended to
+*		10 - symbol declaring the next argument gives a file for both
+*			output and errors
+*		11 - same as 10, but the file is appended to
+*		12 - symbol declaring the next argument gives an output file
+*			that is compressed with gzip
+*		13 - symbol declaring the next argument gives an input file
+*			that is decompressed with gzip
 *
 *---------------------------------------------------------------------*/
 int argType(char* arg) {
@@ -122,6 +195,33 @@ int argType(char* arg) {
 	else if (strcmp(arg, "&") == 0) {
 		return 4;
 	}
+	else if (strcmp(arg, ">>") == 0) {
+		return 5;
+	}
+	else if (strcmp(arg, "<<") == 0) {
+		return 6;
+	}
+	else if (strcmp(arg, "<<<") == 0) {
+		return 7;
+	}
+	else if (strcmp(arg, "2>") == 0) {
+		return 8;
+	}
+	else if (strcmp(arg, "2>>") == 0) {
+		return 9;
+	}
+	else if (strcmp(arg, "&>") == 0) {
+		return 10;
+	}
+	else if (strcmp(arg, "&>>") == 0) {
+		return 11;
+	}
+	else if (strcmp(arg, ">z") == 0) {
+		return 12;
+	}
+	else if (strcmp(arg, "<z") == 0) {
+		return 13;
+	}
 	return 1;
 }
 
@@ -131,17 +231,20 @@ int argType(char* arg) {
 *  varExpansion
 * -------------
 *  Modifies a given string such that substrings of "$$" are replaced
-*  with the PID of the shell.
+*  with the PID of the shell, even in a child of the shell, and "$NAME"
+*  or "${NAME}" with the value of the shell variable NAME.
 *
 *  Fulfills requirement 3 of the assignment by expanding the variable
 *  "$$" into the PID of the shell itself.
 *
 * -------------
 *
-*  string: a string (char*) that is to undergo variable expansion
+*  string: a string (char*) of length MAX_LEN that is to undergo
+*			variable expansion
 *
 *  Returns the string with all "$$" substrings replaced with the shell
-*  PID.
+*  PID. Variables that are not set expand to nothing, and the result
+*  is cut off at MAX_LEN.
 *
 *---------------------------------------------------------------------*/
 char* varExpansion(char* string) {
@@ -149,7 +252,11 @@ char* varExpansion(char* string) {
 	char holder[MAX_LEN];
 	char* ptr;
 	char* tmp;
-	pid_t pid = getpid();
+	char* value;
+	pid_t pid = shellPid;
+	int len = 0;
+	int nameLen;
+	int braced;
 
 	while ((tmp = strstr(string, "$$"))) { // while $$ is still in the string
 		ptr = tmp + 2;
@@ -160,10 +267,186 @@ char* varExpansion(char* string) {
 
 	}
 
+	for (ptr = string; *ptr != '\0' && len < MAX_LEN - 1; ptr++) { // then $NAME and ${NAME}
+		braced = (ptr[0] == '$' && ptr[1] == '{');
+		nameLen = (ptr[0] == '$') ? varNameLen(ptr + 1 + braced) : 0;
+		if (nameLen > 0 && (!braced || ptr[2 + nameLen] == '}')) {
+			value = varGet(ptr + 1 + braced, nameLen);
+			len += snprintf(newString + len, MAX_LEN - len, "%s", (value != NULL) ? value : "");
+			if (len > MAX_LEN - 1) {
+				len = MAX_LEN - 1;
+			}
+			ptr += nameLen + 2 * braced;
+		}
+		else {
+			newString[len++] = *ptr;
+		}
+	}
+	newString[len] = '\0';
+	strcpy(string, newString);
+
 	return string;
 }
 
 
+/*----------------------------------------------------------------------
+*
+*  readHereDoc
+* -------------
+*  Reads the body of a here-document from the given stream, up to the
+*  line that matches the delimiter given on the command line.
+*
+* -------------
+*
+*  c: a pointer to a command struct whose hereDelim is not NULL
+*
+*  stream: a FILE* that the rest of the command lines are read from
+*
+*  Returns nothing, but stores the text in hereBody with $$ expanded
+*  and frees hereDelim.
+*
+*---------------------------------------------------------------------*/
+void readHereDoc(struct command* c, FILE* stream) {
+	char line[MAX_LEN];
+	size_t size = 0;
+	size_t capacity = MAX_LEN;
+	size_t len;
+	int prompt = isatty(fileno(stream)); // only prompt for more lines when someone is typing them
+
+	c->hereBody = calloc(capacity, sizeof(char));
+
+	while (1) {
+		if (prompt) {
+			printf("> ");
+			fflush(stdout);
+		}
+		if (fgets(line, MAX_LEN, stream) == NULL) { // end of input also ends the here-document
+			break;
+		}
+		len = strlen(line);
+		if (len > 0 && line[len - 1] == '\n') {
+			line[--len] = '\0';
+		}
+		if (strcmp(line, c->hereDelim) == 0) {
+			break;
+		}
+
+		varExpansion(line);
+		len = strlen(line);
+		if (size + len + 2 > capacity) { // grow by doubling so long bodies stay linear
+			while (size + len + 2 > capacity) {
+				capacity *= 2;
+			}
+			c->hereBody = realloc(c->hereBody, capacity);
+		}
+		memcpy(c->hereBody + size, line, len);
+		size += len;
+		c->hereBody[size++] = '\n';
+		c->hereBody[size] = '\0';
+	}
+
+	free(c->hereDelim);
+	c->hereDelim = NULL;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  gatherSubstitution
+* -------------
+*  Adds a process substitution, <(cmd) or >(cmd), to a command. The
+*  words of the substitution are gathered from the command line up to
+*  the one ending with the closing parenthesis.
+*
+* -------------
+*
+*  com: a pointer to a command struct that is being parsed
+*
+*  tok: a string (char*) that is the word starting with "<(" or ">("
+*
+*  saveptr: a pointer to the strtok_r() state for the command line
+*
+*  tmp: a string (char*) of length MAX_LEN used as scratch space
+*
+*  where: an int that says what the substitution replaces - the index
+*			in args, -1 for the input file, or ARG_NUM plus the index
+*			in output for an output file
+*
+*  Returns a newly allocated placeholder string for the argument or
+*  file name, which is replaced with a /dev/fd path once the pipe to
+*  the substitution exists.
+*
+*---------------------------------------------------------------------*/
+char* gatherSubstitution(struct command* com, char* tok, char** saveptr, char* tmp, int where) {
+	int sub = com->substNum++;
+	char* placeholder;
+
+	com->substOut[sub] = (tok[0] == '>');
+	com->substArg[sub] = where;
+	com->substZip[sub] = 0;
+
+	strcpy(tmp, tok + 2);
+	while (strlen(tmp) == 0 || tmp[strlen(tmp) - 1] != ')') {
+		tok = strtok_r(NULL, " ", saveptr);
+		if (tok == NULL) { // in case the ")" is missing
+			break;
+		}
+		if (strlen(tmp) > 0) {
+			strcat(tmp, " ");
+		}
+		strcat(tmp, tok);
+	}
+	if (strlen(tmp) > 0 && tmp[strlen(tmp) - 1] == ')') {
+		tmp[strlen(tmp) - 1] = '\0';
+	}
+	com->subst[sub] = calloc(strlen(tmp) + 1, sizeof(char));
+	strcpy(com->subst[sub], tmp); // expanded by the helper, where $$ is still the shell's PID
+
+	placeholder = calloc(strlen(tmp) + 4, sizeof(char));
+	sprintf(placeholder, "%c(%s)", com->substOut[sub] ? '>' : '<', tmp);
+	return placeholder;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  gatherCodec
+* -------------
+*  Adds a compressing redirection, >z or <z, to a command. It is kept
+*  as a process substitution whose helper runs zlib on the file.
+*
+* -------------
+*
+*  com: a pointer to a command struct that is being parsed
+*
+*  path: a string (char*) that is the expanded address of the file
+*
+*  out: an int, 1 for >z and 0 for <z
+*
+*  where: an int that says what the redirection replaces - -1 for the
+*			input file, or ARG_NUM plus the index in output
+*
+*  Returns a newly allocated placeholder string for the file name,
+*  which is replaced with a /dev/fd path once the pipe to the helper
+*  exists.
+*
+*---------------------------------------------------------------------*/
+char* gatherCodec(struct command* com, char* path, int out, int where) {
+	int sub = com->substNum++;
+	char* placeholder;
+
+	com->substOut[sub] = out;
+	com->substArg[sub] = where;
+	com->substZip[sub] = 1;
+	com->subst[sub] = calloc(strlen(path) + 1, sizeof(char));
+	strcpy(com->subst[sub], path);
+
+	placeholder = calloc(strlen(path) + 3, sizeof(char));
+	sprintf(placeholder, "%cz%s", out ? '>' : '<', path);
+	return placeholder;
+}
+
+
 /*----------------------------------------------------------------------
 *
 *  parseCommand
@@ -186,7 +469,10 @@ char* varExpansion(char* string) {
 struct command* parseCommand(char* commandLine) {
 
 	struct command* com = malloc(sizeof(struct command));
-	int bookmark = 0; // 0 = name, 1 = args, 2 = input, 3 = output, 4 = background
+	int bookmark = 0; // 0 = name, 1 = args, 2 = input, 3 = output, 4 = background, 5 = append,
+					  // 6 = here-document, 7 = here-string, 8 = error output, 9 = error append,
+					  // 10 = output and errors, 11 = output and errors append, 12 = compressed
+					  // output, 13 = compressed input
 	char* tmp = calloc(MAX_LEN, sizeof(char)); // temporary string holder for variable expansion
 
 	// for strtok_r
@@ -198,19 +484,18 @@ struct command* parseCommand(char* commandLine) {
 
 	// default values
 	com->input = NULL;
-	com->output = NULL;
+	com->hereDelim = NULL;
+	com->hereBody = NULL;
+	com->outNum = 0;
+	com->errOutput = NULL;
+	com->errAppend = 0;
+	com->errToOut = 0;
+	com->substNum = 0;
+	com->assignNum = 0;
 	com->background = 0;
 
-	// add the command name to both the name and args attributes
+	// the first regular word is the command name, redirections and NAME=value may come before it
 	tok = strtok_r(commandLine, " ", &saveptr);
-	strcpy(tmp, tok);
-	tmp = varExpansion(tmp);
-	com->name = calloc(strlen(tmp) + 1, sizeof(char));
-	strcpy(com->name, tmp);
-	com->args[argNum] = calloc(strlen(tmp) + 1, sizeof(char));
-	strcpy(com->args[argNum++], tmp);
-
-	tok = strtok_r(NULL, " ", &saveptr);
 	while (tok != NULL) {
 
 		// if a lone & is added as an argument instead of as a background flag
@@ -225,24 +510,107 @@ struct command* parseCommand(char* commandLine) {
 		if (bookmark == 2) { // argument is "<"
 			tok = strtok_r(NULL, " ", &saveptr);
 			if (tok != NULL) { // in case nothing is following the "<"
+				free(com->input);
+				free(com->hereDelim);
+				free(com->hereBody);
+				com->hereDelim = NULL;
+				com->hereBody = NULL;
+				if (strncmp(tok, "<(", 2) == 0 && com->substNum < SUB_NUM) { // input from a process substitution
+					com->input = gatherSubstitution(com, tok, &saveptr, tmp, -1);
+				}
+				else {
+					strcpy(tmp, tok);
+					tmp = varExpansion(tmp);
+					com->input = calloc(strlen(tmp) + 1, sizeof(char));
+					strcpy(com->input, tmp);
+				}
+			}
+		}
+		else if (bookmark == 6 || bookmark == 7) { // argument is "<<" or "<<<"
+			tok = strtok_r(NULL, " ", &saveptr);
+			if (tok != NULL) { // in case nothing is following the "<<"
+				strcpy(tmp, tok);
+				free(com->input);
+				free(com->hereDelim);
+				free(com->hereBody);
+				com->input = NULL;
+				com->hereDelim = NULL;
+				com->hereBody = NULL;
+				if (bookmark == 6) { // body is read from the following lines by readHereDoc()
+					com->hereDelim = calloc(strlen(tmp) + 1, sizeof(char));
+					strcpy(com->hereDelim, tmp);
+				}
+				else { // here-string is the word itself plus a newline
+					tmp = varExpansion(tmp);
+					com->hereBody = calloc(strlen(tmp) + 2, sizeof(char));
+					sprintf(com->hereBody, "%s\n", tmp);
+				}
+			}
+		}
+		else if (bookmark == 3 || bookmark == 5 || bookmark == 10 || bookmark == 11) { // argument is ">", ">>", "&>" or "&>>"
+			tok = strtok_r(NULL, " ", &saveptr);
+			if (tok != NULL && com->outNum < OUT_NUM) { // in case nothing is following the ">"
+				if (bookmark >= 10) { // errors follow the output from here on
+					free(com->errOutput);
+					com->errOutput = NULL;
+					com->errToOut = 1;
+				}
+				if (strncmp(tok, ">(", 2) == 0 && com->substNum < SUB_NUM) { // output to a process substitution
+					com->output[com->outNum] = gatherSubstitution(com, tok, &saveptr, tmp, ARG_NUM + com->outNum);
+				}
+				else {
+					strcpy(tmp, tok);
+					tmp = varExpansion(tmp);
+					com->output[com->outNum] = calloc(strlen(tmp) + 1, sizeof(char));
+					strcpy(com->output[com->outNum], tmp);
+				}
+				com->append[com->outNum++] = (bookmark == 5 || bookmark == 11);
+			}
+		}
+		else if (bookmark == 12 || bookmark == 13) { // argument is ">z" or "<z"
+			tok = strtok_r(NULL, " ", &saveptr);
+			if (tok != NULL && com->substNum < SUB_NUM && (bookmark == 13 || com->outNum < OUT_NUM)) {
 				strcpy(tmp, tok);
 				tmp = varExpansion(tmp);
-				com->input = calloc(strlen(tmp) + 1, sizeof(char));
-				strcpy(com->input, tmp);
+				if (bookmark == 12) {
+					com->output[com->outNum] = gatherCodec(com, tmp, 1, ARG_NUM + com->outNum);
+					com->append[com->outNum++] = 0;
+				}
+				else {
+					free(com->input);
+					free(com->hereDelim);
+					free(com->hereBody);
+					com->hereDelim = NULL;
+					com->hereBody = NULL;
+					com->input = gatherCodec(com, tmp, 0, -1);
+				}
 			}
 		}
-		else if (bookmark == 3) { // argument is ">"
+		else if (bookmark == 8 || bookmark == 9) { // argument is "2>" or "2>>"
 			tok = strtok_r(NULL, " ", &saveptr);
-			if (tok != NULL) { // in case nothing is following the ">"
+			if (tok != NULL) { // in case nothing is following the "2>"
 				strcpy(tmp, tok);
 				tmp = varExpansion(tmp);
-				com->output = calloc(strlen(tmp) + 1, sizeof(char));
-				strcpy(com->output, tmp);
+				free(com->errOutput);
+				com->errOutput = calloc(strlen(tmp) + 1, sizeof(char));
+				strcpy(com->errOutput, tmp);
+				com->errAppend = (bookmark == 9);
+				com->errToOut = 0;
 			}
 		}
 		else if (bookmark == 4) { // argument is "&"
 			com->background = 1;
 		}
+		else if ((strncmp(tok, "<(", 2) == 0 || strncmp(tok, ">(", 2) == 0) && com->substNum < SUB_NUM) {
+			com->args[argNum] = gatherSubstitution(com, tok, &saveptr, tmp, argNum);
+			argNum++;
+		}
+		else if (argNum == 0 && varNameLen(tok) > 0 && tok[varNameLen(tok)] == '=' && com->assignNum < ASSIGN_NUM) {
+			strcpy(tmp, tok); // NAME=value before the command name
+			tmp = varExpansion(tmp);
+			com->assign[com->assignNum] = calloc(strlen(tmp) + 1, sizeof(char));
+			strcpy(com->assign[com->assignNum++], tmp);
+		}
 		else { // argument is generic
 			strcpy(tmp, tok);
 			tmp = varExpansion(tmp);
@@ -254,6 +622,12 @@ struct command* parseCommand(char* commandLine) {
 	}
 	com->args[argNum] = NULL;
 
+	// add the command name, which is empty for a line of only redirections
+	com->name = calloc((argNum > 0) ? strlen(com->args[0]) + 1 : 1, sizeof(char));
+	if (argNum > 0) {
+		strcpy(com->name, com->args[0]);
+	}
+
 	return com;
 
 
@@ -9,9 +9,18 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
+#include <stdio.h>
+#include <sys/types.h>
+
 
 #define ARG_NUM 512 // max number of arguments per the rubric
 #define MAX_LEN 2048 // max length of command line per the rubric
+#define OUT_NUM 16 // max number of output redirection targets per command
+#define SUB_NUM 16 // max number of process substitutions per command
+#define ASSIGN_NUM 64 // max number of NAME=value words before a command
+
+
+extern pid_t shellPid; // what $$ expands to, set by the shell so its helpers expand it the same way
 
 /*----------------------------------------------------------------------
 *
@@ -32,8 +41,54 @@
 *  input: a string (char*) that contains the location of a file to
 *			be read from for input redirection
 *
-*  output: a string (char*) that contains the location of a file to
-*			be written to for output redirection
+*  hereDelim: a string (char*) that contains the line which ends a
+*			here-document, or NULL once the body has been read
+*
+*  hereBody: a string (char*) that contains the text given to the
+*			command as input by a here-document or here-string
+*
+*  output: an array of strings (char**) that contains the locations
+*			of files to be written to for output redirection - the
+*			output of the command is copied to every file listed
+*
+*  append: an array of integers matching output, where 0 means the
+*			file is truncated and 1 means the output is appended
+*			to the end of the file
+*
+*  outNum: an integer that contains the number of output files
+*
+*  errOutput: a string (char*) that contains the location of a file
+*			to be written to for error output redirection, 2>
+*
+*  errAppend: an integer, where 0 means errOutput is truncated and 1
+*			means the errors are appended to the end of the file
+*
+*  errToOut: an integer, where 1 means errors go wherever the output
+*			goes, &>, and 0 means they are left alone
+*
+*  subst: an array of strings (char**) that contains the command lines
+*			of process substitutions, <(cmd) and >(cmd)
+*
+*  substOut: an array of integers matching subst, where 0 means the
+*			command reads the output of the substitution, <(cmd), and
+*			1 means the command writes to its input, >(cmd)
+*
+*  substArg: an array of integers matching subst that says what is
+*			replaced with the /dev/fd path of the substitution's pipe -
+*			the index in args, -1 for the input file, or ARG_NUM plus
+*			the index in output for an output file
+*
+*  substZip: an array of integers matching subst, where 1 means the
+*			substitution is a compressing redirection, >z or <z, and
+*			subst holds the path of the gzip file instead of a command
+*
+*  substNum: an integer that contains the number of substitutions
+*
+*  assign: an array of strings (char**) that contains the NAME=value
+*			words before the command name, which are exported to the
+*			command, or set in the shell if there is no command
+*
+*  assignNum: an integer that contains the number of assignments
 *
 *  background: an integer, where 0 means that the command is to be
 *				run in the foreground and 1 means the command is to
@@ -44,7 +99,21 @@ struct command {
 	char* name;
 	char* args[ARG_NUM];
 	char* input;
-	char* output;
+	char* hereDelim;
+	char* hereBody;
+	char* output[OUT_NUM];
+	int append[OUT_NUM];
+	int outNum;
+	char* errOutput;
+	int errAppend;
+	int errToOut;
+	char* subst[SUB_NUM];
+	int substOut[SUB_NUM];
+	int substArg[SUB_NUM];
+	int substZip[SUB_NUM];
+	int substNum;
+	char* assign[ASSIGN_NUM];
+	int assignNum;
 	int background;
 };
 
@@ -71,6 +140,20 @@ struct command {
 *		2 - symbol declaring the next argument gives an input file
 *		3 - symbol declaring the next argument gives an output file
 *		4 - ampersand, declares the process runs in the background
+*		5 - symbol declaring the next argument gives an output file
+*			that is to be appended to
+*		6 - symbol declaring the next argument ends a here-document
+*		7 - symbol declaring the next argument is a here-string
+*		8 - symbol declaring the next argument gives an error output
+*			file
+*		9 - same as 8, but the file is appended to
+*		10 - symbol declaring the next argument gives a file for both
+*			output and errors
+*		11 - same as 10, but the file is appended to
+*		12 - symbol declaring the next argument gives an output file
+*			that is compressed with gzip
+*		13 - symbol declaring the next argument gives an input file
+*			that is decompressed with gzip
 *
 *---------------------------------------------------------------------*/
 int argType(char* arg);
@@ -93,6 +176,79 @@ int argType(char* arg);
 void freeCommand(struct command* toFree);
 
 
+/*----------------------------------------------------------------------
+*
+*  gatherCodec
+* -------------
+*  Adds a compressing redirection, >z or <z, to a command. It is kept
+*  as a process substitution whose helper runs zlib on the file.
+*
+* -------------
+*
+*  com: a pointer to a command struct that is being parsed
+*
+*  path: a string (char*) that is the expanded address of the file
+*
+*  out: an int, 1 for >z and 0 for <z
+*
+*  where: an int that says what the redirection replaces - -1 for the
+*			input file, or ARG_NUM plus the index in output
+*
+*  Returns a newly allocated placeholder string for the file name,
+*  which is replaced with a /dev/fd path once the pipe to the helper
+*  exists.
+*
+*---------------------------------------------------------------------*/
+char* gatherCodec(struct command* com, char* path, int out, int where);
+
+
+/*----------------------------------------------------------------------
+*
+*  gatherSubstitution
+* -------------
+*  Adds a process substitution, <(cmd) or >(cmd), to a command. The
+*  words of the substitution are gathered from the command line up to
+*  the one ending with the closing parenthesis.
+*
+* -------------
+*
+*  com: a pointer to a command struct that is being parsed
+*
+*  tok: a string (char*) that is the word starting with "<(" or ">("
+*
+*  saveptr: a pointer to the strtok_r() state for the command line
+*
+*  tmp: a string (char*) of length MAX_LEN used as scratch space
+*
+*  where: an int that says what the substitution replaces - the index
+*			in args, -1 for the input file, or ARG_NUM plus the index
+*			in output for an output file
+*
+*  Returns a newly allocated placeholder string for the argument or
+*  file name, which is replaced with a /dev/fd path once the pipe to
+*  the substitution exists.
+*
+*---------------------------------------------------------------------*/
+char* gatherSubstitution(struct command* com, char* tok, char** saveptr, char* tmp, int where);
+
+
+/*----------------------------------------------------------------------
+*
+*  isAssignment
+* -------------
+*  Checks if a command line only sets shell variables, NAME=value words
+*  with no command name and no redirections.
+*
+* -------------
+*
+*  c: a command struct that has been parsed
+*
+*  Returns 1 if it only sets variables, 0 otherwise.
+*
+*---------------------------------------------------------------------*/
+int isAssignment(struct command* c);
+
+
 /*----------------------------------------------------------------------
 *
 *  parseCommand
@@ -133,22 +289,45 @@ struct command* parseCommand(char* commandLine);
 void printCommand(struct command* toPrint);
 
 
+/*----------------------------------------------------------------------
+*
+*  readHereDoc
+* -------------
+*  Reads the body of a here-document from the given stream, up to the
+*  line that matches the delimiter given on the command line.
+*
+* -------------
+*
+*  c: a pointer to a command struct whose hereDelim is not NULL
+*
+*  stream: a FILE* that the rest of the command lines are read from
+*
+*  Returns nothing, but stores the text in hereBody with $$ expanded
+*  and frees hereDelim.
+*
+*---------------------------------------------------------------------*/
+void readHereDoc(struct command* c, FILE* stream);
+
+
 /*----------------------------------------------------------------------
 *
 *  varExpansion
 * -------------
 *  Modifies a given string such that substrings of "$$" are replaced
-*  with the PID of the shell.
+*  with the PID of the shell, even in a child of the shell, and "$NAME"
+*  or "${NAME}" with the value of the shell variable NAME.
 *
 *  Fulfills requirement 3 of the assignment by expanding the variable
 *  "$$" into the PID of the shell itself.
 *
 * -------------
 *
-*  string: a string (char*) that is to undergo variable expansion
+*  string: a string (char*) of length MAX_LEN that is to undergo
+*			variable expansion
 *
 *  Returns the string with all "$$" substrings replaced with the shell
-*  PID.
+*  PID. Variables that are not set expand to nothing, and the result
+*  is cut off at MAX_LEN.
 *
 *---------------------------------------------------------------------*/
 char* varExpansion(char* string);
@@ -0,0 +1,538 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for tab completion. The trie of PATH executables keeps a count of
+* the names below each node, so removing a name can free the branch that only led to it. Each
+* PATH directory has an inotify watch, and when a file in one changes, only that name is checked
+* again in every PATH directory, since an earlier directory can hide or reveal the same name.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "command.h"
+#include "complete.h"
+
+
+/*----------------------------------------------------------------------
+*
+*  struct trieNode
+* -------------
+*  Contains one letter of the names in the trie of PATH executables.
+*
+* -------------
+*
+*  letter: a char that is the letter this node adds to its parent's
+*			prefix
+*
+*  terminal: an int, 1 if an executable's name ends at this node
+*
+*  count: an int that is the number of names ending at or below this
+*			node
+*
+*  child: a pointer to the first trieNode one letter further, the
+*			children are kept sorted by letter
+*
+*  sibling: a pointer to the next trieNode with the same parent
+*
+*---------------------------------------------------------------------*/
+struct trieNode {
+	char letter;
+	int terminal;
+	int count;
+	struct trieNode* child;
+	struct trieNode* sibling;
+};
+
+
+struct trieNode trieRoot; // empty prefix, never freed
+char* indexedPath = NULL; // value of PATH the trie was built from, NULL before it is built
+char* pathDirs[PATH_DIRS];
+int pathWatch[PATH_DIRS]; // inotify watch descriptor of each directory
+int pathNum = 0;
+int pathNotify = -1;
+
+
+/*----------------------------------------------------------------------
+*
+*  freeTrie
+* -------------
+*  Frees a node, its siblings after it, and everything below them.
+*
+* -------------
+*
+*  node: a pointer to the first trieNode to free, or NULL
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void freeTrie(struct trieNode* node) {
+	struct trieNode* next;
+
+	while (node != NULL) {
+		next = node->sibling;
+		freeTrie(node->child);
+		free(node);
+		node = next;
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  findNode
+* -------------
+*  Follows a prefix down the trie.
+*
+* -------------
+*
+*  prefix: a string (char*) to look for
+*
+*  Returns the node the prefix ends at, or NULL if no name starts with
+*  the prefix.
+*
+*---------------------------------------------------------------------*/
+struct trieNode* findNode(char* prefix) {
+	struct trieNode* node = &trieRoot;
+	struct trieNode* curr;
+
+	for (; *prefix != '\0'; prefix++) {
+		for (curr = node->child; curr != NULL && curr->letter < *prefix; curr = curr->sibling) {
+		}
+		if (curr == NULL || curr->letter != *prefix) {
+			return NULL;
+		}
+		node = curr;
+	}
+	return node;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  trieInsert
+* -------------
+*  Adds a name to the trie if it is not already there.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name of an executable
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void trieInsert(char* name) {
+	struct trieNode* node = &trieRoot;
+	struct trieNode** link;
+	struct trieNode* added;
+	char* ptr;
+
+	if (*name == '\0' || ((node = findNode(name)) != NULL && node->terminal)) {
+		return;
+	}
+
+	node = &trieRoot;
+	for (ptr = name; *ptr != '\0'; ptr++) {
+		node->count++;
+		for (link = &node->child; *link != NULL && (*link)->letter < *ptr; link = &(*link)->sibling) {
+		}
+		if (*link == NULL || (*link)->letter != *ptr) {
+			added = calloc(1, sizeof(struct trieNode));
+			added->letter = *ptr;
+			added->sibling = *link;
+			*link = added;
+		}
+		node = *link;
+	}
+	node->count++;
+	node->terminal = 1;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  trieRemove
+* -------------
+*  Removes a name from the trie if it is there, freeing the branch that
+*  no other name uses.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name of an executable
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void trieRemove(char* name) {
+	struct trieNode* node = findNode(name);
+	struct trieNode** link;
+	char* ptr;
+
+	if (*name == '\0' || node == NULL || !node->terminal) {
+		return;
+	}
+
+	node = &trieRoot;
+	for (ptr = name; *ptr != '\0'; ptr++) {
+		node->count--;
+		for (link = &node->child; (*link)->letter != *ptr; link = &(*link)->sibling) {
+		}
+		if ((*link)->count == 1) { // nothing else below here, cut off the branch
+			node = *link;
+			*link = node->sibling;
+			node->sibling = NULL;
+			freeTrie(node);
+			return;
+		}
+		node = *link;
+	}
+	node->count--;
+	node->terminal = 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  isExecutable
+* -------------
+*  Checks if a directory holds a file that can be run with a name.
+*
+* -------------
+*
+*  dir: a string (char*) that contains the address of the directory
+*
+*  name: a string (char*) that contains the name of the file
+*
+*  Returns 1 if it is a regular file with an execute bit set, 0
+*  otherwise.
+*
+*---------------------------------------------------------------------*/
+int isExecutable(char* dir, char* name) {
+	char path[MAX_LEN];
+	struct stat info;
+
+	snprintf(path, MAX_LEN, "%s/%s", dir, name);
+	return stat(path, &info) == 0 && S_ISREG(info.st_mode) && (info.st_mode & 0111);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  refreshName
+* -------------
+*  Checks a name against every PATH directory after one of them
+*  changed, and adds it to or removes it from the trie.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name of the changed file
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void refreshName(char* name) {
+	int i;
+
+	for (i = 0; i < pathNum; i++) {
+		if (isExecutable(pathDirs[i], name)) {
+			trieInsert(name);
+			return;
+		}
+	}
+	trieRemove(name);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  buildIndex
+* -------------
+*  Throws away the trie and builds it again from the current PATH,
+*  watching each directory for changes.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void buildIndex() {
+	char* path = getenv("PATH");
+	char* copy;
+	char* dir;
+	char* saveptr;
+	DIR* stream;
+	struct dirent* entry;
+	int i;
+
+	for (i = 0; i < pathNum; i++) {
+		free(pathDirs[i]);
+	}
+	if (pathNotify != -1) {
+		close(pathNotify); // also removes every watch
+	}
+	freeTrie(trieRoot.child);
+	memset(&trieRoot, 0, sizeof(trieRoot));
+	free(indexedPath);
+
+	indexedPath = strdup(path != NULL ? path : "");
+	pathNotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	pathNum = 0;
+
+	copy = strdup(indexedPath);
+	for (dir = strtok_r(copy, ":", &saveptr); dir != NULL && pathNum < PATH_DIRS; dir = strtok_r(NULL, ":", &saveptr)) {
+		stream = opendir(dir);
+		if (stream == NULL) {
+			continue;
+		}
+		pathDirs[pathNum] = strdup(dir);
+		pathWatch[pathNum] = -1;
+		if (pathNotify != -1) {
+			pathWatch[pathNum] = inotify_add_watch(pathNotify, dir, IN_CREATE | IN_DELETE | IN_MOVED_FROM
+				| IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF);
+		}
+		while ((entry = readdir(stream)) != NULL) {
+			if (entry->d_type != DT_DIR && entry->d_name[0] != '.' && isExecutable(dir, entry->d_name)) {
+				trieInsert(entry->d_name);
+			}
+		}
+		closedir(stream);
+		pathNum++;
+	}
+	free(copy);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  updateIndex
+* -------------
+*  Brings the trie up to date before a completion. Builds it the first
+*  time and again whenever PATH changed or a PATH directory was moved
+*  or deleted, and otherwise only checks the names that inotify says
+*  changed.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void updateIndex() {
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct inotify_event* event;
+	char* path = getenv("PATH");
+	int rebuild = 0;
+	ssize_t len;
+	char* ptr;
+
+	if (indexedPath == NULL || strcmp(indexedPath, path != NULL ? path : "") != 0) {
+		buildIndex();
+		return;
+	}
+
+	while (pathNotify != -1 && (len = read(pathNotify, buffer, sizeof(buffer))) > 0) {
+		for (ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + event->len) {
+			event = (struct inotify_event*)ptr;
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_Q_OVERFLOW)) {
+				rebuild = 1;
+			}
+			else if (event->len > 0) {
+				refreshName(event->name);
+			}
+		}
+	}
+	if (rebuild) {
+		buildIndex();
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  collectNames
+* -------------
+*  Adds every name at or below a node to a list, in sorted order.
+*
+* -------------
+*
+*  node: a pointer to the trieNode to start at
+*
+*  name: a string (char*) of length MAX_LEN that holds the prefix that
+*			leads to node, which is used as scratch space
+*
+*  len: an int that is the length of the prefix
+*
+*  list, max: see completeCommand()
+*
+*  found: a pointer to an int that is the number of names in list so
+*			far
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void collectNames(struct trieNode* node, char* name, int len, char** list, int max, int* found) {
+	struct trieNode* curr;
+
+	if (*found >= max || len >= MAX_LEN - 1) {
+		return;
+	}
+	if (node->terminal) {
+		name[len] = '\0';
+		list[(*found)++] = strdup(name);
+	}
+	for (curr = node->child; curr != NULL; curr = curr->sibling) {
+		name[len] = curr->letter;
+		collectNames(curr, name, len + 1, list, max, found);
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  completeCommand
+* -------------
+*  Finds every executable on PATH whose name starts with a prefix.
+*
+* -------------
+*
+*  prefix: a string (char*) that contains the start of the name
+*
+*  common: a string (char*) of length size that is set to the longest
+*			name every match starts with
+*
+*  size: an int that is the length of common
+*
+*  list: an array of max strings (char**) that is filled with newly
+*			allocated copies of the matches, in sorted order
+*
+*  max: an int that is the most matches to put in list
+*
+*  Returns the number of matches put in list.
+*
+*---------------------------------------------------------------------*/
+int completeCommand(char* prefix, char* common, int size, char** list, int max) {
+	char name[MAX_LEN];
+	struct trieNode* node;
+	int len = strlen(prefix);
+	int found = 0;
+
+	updateIndex();
+	snprintf(common, size, "%s", prefix);
+	node = findNode(prefix);
+	if (node == NULL || len >= MAX_LEN) {
+		return 0;
+	}
+
+	// the common part goes on as long as there is only one way down
+	while (!node->terminal && node->child != NULL && node->child->sibling == NULL && len < size - 1) {
+		node = node->child;
+		common[len++] = node->letter;
+	}
+	common[len] = '\0';
+
+	strcpy(name, common);
+	collectNames(node, name, len, list, max, &found);
+	return found;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  compareNames
+* -------------
+*  Compares two strings for qsort().
+*
+* -------------
+*
+*  a, b: pointers (const void*) to the strings (char*) to compare
+*
+*  Returns less than, equal to, or more than 0 like strcmp().
+*
+*---------------------------------------------------------------------*/
+int compareNames(const void* a, const void* b) {
+	return strcmp(*(char**)a, *(char**)b);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  completeFile
+* -------------
+*  Finds every file whose path starts with a prefix. Directories are
+*  listed with a trailing slash. The whole directory is read even when
+*  there are more than max matches, so common is shared by all of them
+*  and not just the ones listed.
+*
+* -------------
+*
+*  prefix, common, size, list, max: see completeCommand(), with paths
+*			instead of names
+*
+*  Returns the number of matches put in list.
+*
+*---------------------------------------------------------------------*/
+int completeFile(char* prefix, char* common, int size, char** list, int max) {
+	char dir[MAX_LEN];
+	char match[MAX_LEN * 2]; // directory plus a file name
+	char shown[MAX_LEN * 2]; // the match as it is completed, with a slash after a directory
+	char* base = strrchr(prefix, '/');
+	DIR* stream;
+	struct dirent* entry;
+	struct stat info;
+	int dirLen;
+	int found = 0;
+	int total = 0; // matches, including the ones past max
+	int j;
+
+	snprintf(common, size, "%s", prefix);
+	if (base != NULL) {
+		dirLen = base - prefix + 1;
+		snprintf(dir, MAX_LEN, "%.*s", dirLen, prefix);
+		base++;
+	}
+	else {
+		dirLen = 0;
+		strcpy(dir, "./");
+		base = prefix;
+	}
+
+	stream = opendir(dir);
+	if (stream == NULL) {
+		return 0;
+	}
+	while ((entry = readdir(stream)) != NULL) {
+		if (strncmp(entry->d_name, base, strlen(base)) != 0 || strcmp(entry->d_name, ".") == 0
+			|| strcmp(entry->d_name, "..") == 0 || (entry->d_name[0] == '.' && base[0] != '.')) {
+			continue;
+		}
+		snprintf(match, sizeof(match), "%s%s", dir, entry->d_name);
+		snprintf(shown, sizeof(shown), "%.*s%s%s", dirLen, prefix, entry->d_name,
+			(stat(match, &info) == 0 && S_ISDIR(info.st_mode)) ? "/" : "");
+
+		if (total++ == 0) {
+			snprintf(common, size, "%s", shown);
+		}
+		else {
+			for (j = 0; common[j] != '\0' && common[j] == shown[j]; j++) {
+			}
+			common[j] = '\0';
+		}
+		if (found < max) {
+			list[found++] = strdup(shown);
+		}
+	}
+	closedir(stream);
+
+	if (found > 0) {
+		qsort(list, found, sizeof(char*), &compareNames);
+	}
+	return found;
+}
@@ -0,0 +1,64 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for tab completion. Command names are completed from a
+* prefix trie of every executable on PATH, which is built the first time it is needed and then
+* kept up to date with inotify, so a completion only walks as many nodes as the prefix is long.
+* File names are completed by reading the directory of the word being completed.
+*/
+
+#ifndef COMPLETE_H
+#define COMPLETE_H
+
+
+#define COMPLETE_MAX 256 // most matches listed at once
+#define PATH_DIRS 64 // most directories on PATH that are indexed
+
+
+/*----------------------------------------------------------------------
+*
+*  completeCommand
+* -------------
+*  Finds every executable on PATH whose name starts with a prefix.
+*
+* -------------
+*
+*  prefix: a string (char*) that contains the start of the name
+*
+*  common: a string (char*) of length size that is set to the longest
+*			name every match starts with
+*
+*  size: an int that is the length of common
+*
+*  list: an array of max strings (char**) that is filled with newly
+*			allocated copies of the matches, in sorted order
+*
+*  max: an int that is the most matches to put in list
+*
+*  Returns the number of matches put in list.
+*
+*---------------------------------------------------------------------*/
+int completeCommand(char* prefix, char* common, int size, char** list, int max);
+
+
+/*----------------------------------------------------------------------
+*
+*  completeFile
+* -------------
+*  Finds every file whose path starts with a prefix. Directories are
+*  listed with a trailing slash. The whole directory is read even when
+*  there are more than max matches, so common is shared by all of them
+*  and not just the ones listed.
+*
+* -------------
+*
+*  prefix, common, size, list, max: see completeCommand(), with paths
+*			instead of names
+*
+*  Returns the number of matches put in list.
+*
+*---------------------------------------------------------------------*/
+int completeFile(char* prefix, char* common, int size, char** list, int max);
+
+#endif
@@ -0,0 +1,527 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for coprocesses and the built in commands that use them. Replies
+* are read into a buffer kept with each coprocess, so coread returns exactly one line and keeps
+* the rest for next time. Both pipes are closed on exec so other commands never hold them open.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "builtin.h"
+#include "coproc.h"
+#include "vars.h"
+
+
+/*----------------------------------------------------------------------
+*
+*  struct coproc
+* -------------
+*  Contains one running coprocess.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name given to coproc, or
+*			NULL if the slot is empty
+*
+*  pid: a pid_t of the coprocess
+*
+*  toFD: an int that is the write end of the pipe to its stdin, or -1
+*			once closed with coclose
+*
+*  fromFD: an int that is the read end of the pipe from its stdout
+*
+*  buffer: an array of chars holding what has been read from the
+*			coprocess but not returned by coread yet
+*
+*  buffered: an int that is the number of chars in buffer
+*
+*  taken: an int, 1 once the coprocess is in the background job list
+*
+*  done: an int, 1 once the coprocess has finished, though its output
+*			can still be read until it runs out
+*
+*---------------------------------------------------------------------*/
+struct coproc {
+	char* name;
+	pid_t pid;
+	int toFD;
+	int fromFD;
+	char buffer[COPROC_BUFFER];
+	int buffered;
+	int taken;
+	int done;
+};
+
+
+struct coproc coprocs[COPROC_NUM];
+
+
+/*----------------------------------------------------------------------
+*
+*  findCoproc
+* -------------
+*  Finds a running coprocess by name.
+*
+* -------------
+*
+*  name: a string (char*) that starts with the name
+*
+*  len: an int that is the length of the name
+*
+*  Returns a pointer to the coproc struct, or NULL if no coprocess has
+*  that name.
+*
+*---------------------------------------------------------------------*/
+struct coproc* findCoproc(char* name, int len) {
+	int i;
+
+	for (i = 0; i < COPROC_NUM; i++) {
+		if (coprocs[i].name != NULL && strncmp(coprocs[i].name, name, len) == 0 && coprocs[i].name[len] == '\0') {
+			return &coprocs[i];
+		}
+	}
+	return NULL;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  releaseCoproc
+* -------------
+*  Closes the pipes to a coprocess, empties its slot and unsets its
+*  NAME_PID variable.
+*
+* -------------
+*
+*  co: a pointer to the coproc struct to empty
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void releaseCoproc(struct coproc* co) {
+	char pidName[MAX_LEN];
+
+	if (co->toFD != -1) {
+		close(co->toFD);
+	}
+	close(co->fromFD);
+	snprintf(pidName, MAX_LEN, "%s_PID", co->name);
+	varUnset(pidName, strlen(pidName));
+	free(co->name);
+	co->name = NULL;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocTake
+* -------------
+*  Hands a newly started coprocess to the shell's list of background
+*  jobs. Each coprocess is handed over once.
+*
+* -------------
+*
+*  Returns the PID of a coprocess started since the last call, or -1
+*  if there is none.
+*
+*---------------------------------------------------------------------*/
+pid_t coprocTake() {
+	int i;
+
+	for (i = 0; i < COPROC_NUM; i++) {
+		if (coprocs[i].name != NULL && !coprocs[i].taken) {
+			coprocs[i].taken = 1;
+			return coprocs[i].pid;
+		}
+	}
+	return -1;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocReaped
+* -------------
+*  Marks a coprocess as finished once it has been reaped. Its output
+*  stays readable with coread until it runs out.
+*
+* -------------
+*
+*  pid: a pid_t of a background job that finished
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void coprocReaped(pid_t pid) {
+	int i;
+
+	for (i = 0; i < COPROC_NUM; i++) {
+		if (coprocs[i].name != NULL && !coprocs[i].done && coprocs[i].pid == pid) {
+			coprocs[i].done = 1;
+			if (coprocs[i].toFD != -1) {
+				close(coprocs[i].toFD);
+				coprocs[i].toFD = -1;
+			}
+		}
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocCloseFds
+* -------------
+*  Closes the shell's ends of every coprocess pipe. Called in a child
+*  that is forked but never calls exec, where close-on-exec does not
+*  help, so coclose still gives the coprocess the end of its input.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void coprocCloseFds() {
+	int i;
+
+	for (i = 0; i < COPROC_NUM; i++) {
+		if (coprocs[i].name != NULL && coprocs[i].toFD != -1) {
+			close(coprocs[i].toFD);
+		}
+		if (coprocs[i].name != NULL && coprocs[i].fromFD != -1) {
+			close(coprocs[i].fromFD);
+		}
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocCloseAll
+* -------------
+*  Ends every coprocess when the shell exits. Their input is closed so
+*  they can finish on their own, and any still running after a second
+*  are sent SIGTERM.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void coprocCloseAll() {
+	int running = 0;
+	int tries;
+	int i;
+
+	for (i = 0; i < COPROC_NUM; i++) {
+		if (coprocs[i].name != NULL && coprocs[i].done) {
+			releaseCoproc(&coprocs[i]);
+		}
+		else if (coprocs[i].name != NULL) {
+			if (coprocs[i].toFD != -1) {
+				close(coprocs[i].toFD);
+				coprocs[i].toFD = -1;
+			}
+			running = 1;
+		}
+	}
+
+	for (tries = 0; running && tries < 100; tries++) { // give them a second to see the end of their input
+		running = 0;
+		for (i = 0; i < COPROC_NUM; i++) {
+			if (coprocs[i].name != NULL && waitpid(coprocs[i].pid, NULL, WNOHANG) != 0) {
+				releaseCoproc(&coprocs[i]);
+			}
+			else if (coprocs[i].name != NULL) {
+				running = 1;
+			}
+		}
+		if (running) {
+			usleep(10000);
+		}
+	}
+
+	for (i = 0; i < COPROC_NUM; i++) {
+		if (coprocs[i].name != NULL) {
+			kill(coprocs[i].pid, SIGTERM);
+			waitpid(coprocs[i].pid, NULL, 0);
+			releaseCoproc(&coprocs[i]);
+		}
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCoproc
+* -------------
+*  Code for the built in coproc command, "coproc NAME cmd [args]",
+*  which starts cmd as a coprocess in the background.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if the coprocess was started, returns 1 and prints a
+*  message with the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInCoproc(int argc, char* argv[], struct builtinIO* io) {
+	struct coproc* co = NULL;
+	int toPipe[2];
+	int fromPipe[2];
+	char pidName[MAX_LEN];
+	char pidText[16];
+	int i;
+
+	if (argc < 3) {
+		dprintf(io->err, "usage: coproc NAME COMMAND [ARGS]\n");
+		return 1;
+	}
+	if (varNameLen(argv[1]) != (int) strlen(argv[1])) { // NAME_PID has to be a variable name
+		dprintf(io->err, "coproc: %s: not a valid name\n", argv[1]);
+		return 1;
+	}
+	co = findCoproc(argv[1], strlen(argv[1]));
+	if (co != NULL && !co->done) {
+		dprintf(io->err, "coproc: %s is already running\n", argv[1]);
+		return 1;
+	}
+	if (co != NULL) { // the name is free again once the old one finished
+		releaseCoproc(co);
+		co = NULL;
+	}
+	for (i = 0; i < COPROC_NUM && co == NULL; i++) {
+		if (coprocs[i].name == NULL) {
+			co = &coprocs[i];
+		}
+	}
+	if (co == NULL) {
+		dprintf(io->err, "coproc: too many coprocesses\n");
+		return 1;
+	}
+
+	if (pipe2(toPipe, O_CLOEXEC) == -1) {
+		perror("coproc pipe()");
+		return 1;
+	}
+	if (pipe2(fromPipe, O_CLOEXEC) == -1) {
+		perror("coproc pipe()");
+		close(toPipe[0]);
+		close(toPipe[1]);
+		return 1;
+	}
+
+	fflush(stdout);
+	co->pid = fork();
+	switch (co->pid) {
+	case -1:
+		perror("fork()\n");
+		exit(1);
+		break;
+
+	case 0: // coprocess, ignores SIGINT like other background jobs
+		signal(SIGTSTP, SIG_IGN); // a stopped coprocess would leave coread waiting
+		if (dup2(toPipe[0], 0) == -1 || dup2(fromPipe[1], 1) == -1) {
+			perror("coproc dup2()");
+			_exit(1);
+		}
+		execvpe(argv[2], argv + 2, varEnviron());
+
+		perror(argv[2]);
+		_exit(1);
+		break;
+
+	default: // parent
+		close(toPipe[0]);
+		close(fromPipe[1]);
+		co->name = strdup(argv[1]);
+		co->toFD = toPipe[1];
+		co->fromFD = fromPipe[0];
+		co->buffered = 0;
+		co->taken = 0;
+		co->done = 0;
+		snprintf(pidName, MAX_LEN, "%s_PID", co->name);
+		snprintf(pidText, sizeof(pidText), "%d", co->pid);
+		varSet(pidName, strlen(pidName), pidText, 0);
+		printf("background pid is %d\n", co->pid);
+		fflush(stdout);
+	}
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCowrite
+* -------------
+*  Code for the built in cowrite command, "cowrite NAME [words]", which
+*  sends the words to a coprocess as one line.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if the line was sent, returns 1 and prints a message with
+*  the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInCowrite(int argc, char* argv[], struct builtinIO* io) {
+	struct coproc* co;
+	char line[MAX_LEN];
+	int len = 0;
+	int i;
+	ssize_t n;
+
+	if (argc < 2) {
+		dprintf(io->err, "usage: cowrite NAME [WORDS]\n");
+		return 1;
+	}
+	co = findCoproc(argv[1], strlen(argv[1]));
+	if (co == NULL || co->toFD == -1) {
+		dprintf(io->err, "cowrite: %s is not running or its input is closed\n", argv[1]);
+		return 1;
+	}
+
+	line[0] = '\0';
+	for (i = 2; i < argc && len < MAX_LEN - 1; i++) {
+		len += snprintf(line + len, MAX_LEN - 1 - len, (i > 2) ? " %s" : "%s", argv[i]);
+	}
+	if (len > MAX_LEN - 2) {
+		len = MAX_LEN - 2;
+	}
+	line[len++] = '\n';
+
+	signal(SIGPIPE, SIG_IGN); // a coprocess that died is reported instead of killing the shell
+	for (i = 0; i < len; i += n) {
+		n = write(co->toFD, line + i, len - i);
+		if (n == -1 && errno == EINTR) {
+			n = 0;
+		}
+		else if (n == -1) {
+			dprintf(io->err, "cowrite: %s: %s\n", argv[1], strerror(errno));
+			break;
+		}
+	}
+	signal(SIGPIPE, SIG_DFL);
+
+	return (i < len) ? 1 : 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCoread
+* -------------
+*  Code for the built in coread command, "coread [-t SECONDS] NAME",
+*  which prints the next line from a coprocess.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if a line was printed, returns 1 if the coprocess ended
+*  its output or nothing came before the timeout.
+*
+*---------------------------------------------------------------------*/
+int builtInCoread(int argc, char* argv[], struct builtinIO* io) {
+	struct coproc* co;
+	struct pollfd ready;
+	char* newline;
+	int timeout = -1; // in milliseconds, -1 waits forever
+	int name = 1;
+	int len;
+	ssize_t n;
+
+	if (argc == 4 && strcmp(argv[1], "-t") == 0) {
+		timeout = atof(argv[2]) * 1000;
+		name = 3;
+	}
+	else if (argc != 2) {
+		dprintf(io->err, "usage: coread [-t SECONDS] NAME\n");
+		return 1;
+	}
+	co = findCoproc(argv[name], strlen(argv[name]));
+	if (co == NULL) { // never started, or finished and read to the end
+		dprintf(io->err, "coread: %s is not running\n", argv[name]);
+		return 1;
+	}
+
+	while ((newline = memchr(co->buffer, '\n', co->buffered)) == NULL && co->buffered < COPROC_BUFFER) {
+		ready.fd = co->fromFD;
+		ready.events = POLLIN;
+		n = poll(&ready, 1, timeout);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n == 0) {
+			return 1; // timed out, keep what has come so far
+		}
+		n = read(co->fromFD, co->buffer + co->buffered, COPROC_BUFFER - co->buffered);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		co->buffered += n;
+	}
+
+	if (newline == NULL && co->buffered == 0) { // end of its output
+		if (co->done) {
+			releaseCoproc(co);
+		}
+		return 1;
+	}
+	len = (newline != NULL) ? newline - co->buffer + 1 : co->buffered; // a last line without a newline still counts
+	dprintf(io->out, "%.*s%s", len, co->buffer, (newline != NULL) ? "" : "\n");
+	co->buffered -= len;
+	memmove(co->buffer, co->buffer + len, co->buffered);
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInCoclose
+* -------------
+*  Code for the built in coclose command, "coclose NAME", which closes
+*  the input of a coprocess so it sees the end of its input. What it
+*  still has to say can be read with coread.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if successful, returns 1 and prints a message with the
+*  error otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInCoclose(int argc, char* argv[], struct builtinIO* io) {
+	struct coproc* co;
+
+	if (argc != 2) {
+		dprintf(io->err, "usage: coclose NAME\n");
+		return 1;
+	}
+	co = findCoproc(argv[1], strlen(argv[1]));
+	if (co == NULL || co->toFD == -1) {
+		dprintf(io->err, "coclose: %s is not running or its input is closed\n", argv[1]);
+		return 1;
+	}
+	close(co->toFD);
+	co->toFD = -1;
+	return 0;
+}
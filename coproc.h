@@ -0,0 +1,88 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for coprocesses. "coproc NAME cmd" starts cmd once with its
+* stdin and stdout connected to the shell by pipes, and later command lines talk to it a line at
+* a time with cowrite and coread, so a filter used thousands of times only starts up once. The
+* coprocess is a background job like any other and the shell variable NAME_PID holds its PID.
+*
+* Programs whose output is buffered when it is not a terminal must be told to flush each line,
+* such as "sed -u", or coread waits for replies that are still in their buffer.
+*/
+
+#ifndef COPROC_H
+#define COPROC_H
+
+#include <sys/types.h>
+
+
+#define COPROC_NUM 16 // most coprocesses running at once
+#define COPROC_BUFFER 4096 // longest line read back from a coprocess
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocTake
+* -------------
+*  Hands a newly started coprocess to the shell's list of background
+*  jobs. Each coprocess is handed over once.
+*
+* -------------
+*
+*  Returns the PID of a coprocess started since the last call, or -1
+*  if there is none.
+*
+*---------------------------------------------------------------------*/
+pid_t coprocTake();
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocReaped
+* -------------
+*  Marks a coprocess as finished once it has been reaped. Its output
+*  stays readable with coread until it runs out.
+*
+* -------------
+*
+*  pid: a pid_t of a background job that finished
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void coprocReaped(pid_t pid);
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocCloseFds
+* -------------
+*  Closes the shell's ends of every coprocess pipe. Called in a child
+*  that is forked but never calls exec, where close-on-exec does not
+*  help, so coclose still gives the coprocess the end of its input.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void coprocCloseFds();
+
+
+/*----------------------------------------------------------------------
+*
+*  coprocCloseAll
+* -------------
+*  Ends every coprocess when the shell exits. Their input is closed so
+*  they can finish on their own, and any still running after a second
+*  are sent SIGTERM.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void coprocCloseAll();
+
+#endif
@@ -0,0 +1,926 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for the dag built in command. The graph is checked for unknown
+* dependencies and cycles before anything runs. Targets become ready when their last dependency
+* finishes and are started from a queue, and a pidfd for each running command lets the shell sleep
+* in poll() until one of them exits. Only those PIDs are reaped, so the shell's own background
+* jobs are still reported as usual.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/pidfd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "builtin.h"
+#include "dag.h"
+#include "jobstat.h"
+#include "replay.h"
+
+
+#define NODE_WAITING 0 // some dependencies have not finished
+#define NODE_RUNNING 1
+#define NODE_RAN 2 // its command ran and succeeded
+#define NODE_CURRENT 3 // up to date, or nothing to run
+#define NODE_FAILED 4
+#define NODE_BLOCKED 5 // not run because a dependency failed
+
+
+/*----------------------------------------------------------------------
+*
+*  struct node
+* -------------
+*  Contains one target of the graph.
+*
+* -------------
+*
+*  target: a string (char*) that contains the name of the target,
+*			which is also the file it makes
+*
+*  line: a string (char*) that contains the command line, or NULL if
+*			the target only groups its dependencies
+*
+*  deps: an array of strings (char**) that contains the names of the
+*			dependencies
+*
+*  depNode: an array of ints matching deps that is the index of the
+*			target each one names, or -1 for a plain file
+*
+*  depNum: an int that is the number of dependencies
+*
+*  users: an array of ints that is the index of every target that
+*			depends on this one
+*
+*  userNum: an int that is the number of users
+*
+*  waiting: an int that is the number of dependencies still to finish
+*
+*  state: an int, one of the NODE_ codes
+*
+*  pid: a pid_t of the command while it runs
+*
+*  pidfd: an int that is a file descriptor for the running command
+*			that becomes readable when it exits, or -1
+*
+*  helpers: an array of pid_ts of the command's helper processes
+*
+*  helperNum: an int that is the number of helpers
+*
+*  started: a long that is when the command started, in microseconds
+*
+*  duration: a long that is how long the command ran, in microseconds
+*
+*  path: a long that is the longest run time of any chain of targets
+*			ending with this one, in microseconds
+*
+*  pathPrev: an int that is the dependency before this one on that
+*			chain, or -1 if it starts the chain
+*
+*---------------------------------------------------------------------*/
+struct node {
+	char* target;
+	char* line;
+	char* deps[DAG_DEPS];
+	int depNode[DAG_DEPS];
+	int depNum;
+	int* users;
+	int userNum;
+	int waiting;
+	int state;
+	pid_t pid;
+	int pidfd;
+	pid_t helpers[SUB_NUM + 1];
+	int helperNum;
+	long started;
+	long duration;
+	long path;
+	int pathPrev;
+};
+
+
+/*----------------------------------------------------------------------
+*
+*  struct named
+* -------------
+*  Contains the name of a target and where it is, for sorting and
+*  searching the targets by name.
+*
+* -------------
+*
+*  name: a string (char*) that contains the name of the target
+*
+*  index: an int that is the index of the target
+*
+*---------------------------------------------------------------------*/
+struct named {
+	char* name;
+	int index;
+};
+
+
+pid_t (*dagSpawn)(struct command*, pid_t*, int*) = NULL;
+
+volatile sig_atomic_t dagInterrupted = 0;
+
+
+/*----------------------------------------------------------------------
+*
+*  dagSIGINT
+* -------------
+*  Signal handler for SIGINT while a graph runs. The running commands
+*  are interrupted too, so no more are started.
+*
+* -------------
+*
+*  signum: the signal number, SIGINT
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void dagSIGINT(int signum) {
+	dagInterrupted = 1;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  compareNamed
+* -------------
+*  Compares two named structs by name for qsort() and bsearch().
+*
+* -------------
+*
+*  a, b: pointers to the named structs
+*
+*  Returns the result of strcmp() on the names.
+*
+*---------------------------------------------------------------------*/
+int compareNamed(const void* a, const void* b) {
+	return strcmp(((struct named*) a)->name, ((struct named*) b)->name);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  trimSpace
+* -------------
+*  Removes the spaces and tabs from both ends of a string.
+*
+* -------------
+*
+*  str: a string (char*) that is trimmed in place
+*
+*  Returns a pointer to the first letter that is not a space.
+*
+*---------------------------------------------------------------------*/
+char* trimSpace(char* str) {
+	int len;
+
+	while (*str == ' ' || *str == '\t') {
+		str++;
+	}
+	len = strlen(str);
+	while (len > 0 && (str[len - 1] == ' ' || str[len - 1] == '\t')) {
+		str[--len] = '\0';
+	}
+	return str;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  freeGraph
+* -------------
+*  Frees the targets of a graph.
+*
+* -------------
+*
+*  nodes: an array of num node structs
+*
+*  num: an int that is the number of targets
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void freeGraph(struct node* nodes, int num) {
+	int i;
+	int j;
+
+	for (i = 0; i < num; i++) {
+		free(nodes[i].target);
+		free(nodes[i].line);
+		for (j = 0; j < nodes[i].depNum; j++) {
+			free(nodes[i].deps[j]);
+		}
+		free(nodes[i].users);
+	}
+	free(nodes);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  readGraph
+* -------------
+*  Reads the targets of a graph, one per line.
+*
+* -------------
+*
+*  stream: a FILE* that the graph is read from
+*
+*  name: a string (char*) that names the graph in error messages
+*
+*  num: a pointer to an int that is set to the number of targets
+*
+*  err: an int that is the file descriptor to write errors to
+*
+*  Returns an array of node structs, or NULL and prints a message if
+*  a line is not a target.
+*
+*---------------------------------------------------------------------*/
+struct node* readGraph(FILE* stream, char* name, int* num, int err) {
+	struct node* nodes = NULL;
+	int capacity = 0;
+	char* text = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int lineNum = 0;
+	char* colon;
+	char* semi;
+	char* target;
+	char* dep;
+	char* saveptr;
+	struct node* n;
+
+	*num = 0;
+	while ((len = getline(&text, &size, stream)) != -1) {
+		lineNum++;
+		if (len > 0 && text[len - 1] == '\n') {
+			text[--len] = '\0';
+		}
+		target = trimSpace(text);
+		if (target[0] == '\0' || target[0] == '#') {
+			continue;
+		}
+
+		colon = strchr(target, ':');
+		if (colon != NULL) {
+			*colon = '\0';
+			target = trimSpace(target);
+		}
+		if (colon == NULL || target[0] == '\0' || strpbrk(target, " \t") != NULL) {
+			dprintf(err, "dag: %s:%d: expected \"target: deps ; command\"\n", name, lineNum);
+			break;
+		}
+
+		if (*num == capacity) { // grow by doubling
+			capacity = (capacity == 0) ? 64 : capacity * 2;
+			nodes = realloc(nodes, capacity * sizeof(struct node));
+		}
+		n = &nodes[*num];
+		memset(n, 0, sizeof(struct node));
+		n->target = strdup(target);
+		n->pidfd = -1;
+		n->pathPrev = -1;
+		(*num)++;
+
+		semi = strchr(colon + 1, ';');
+		if (semi != NULL) {
+			*semi = '\0';
+			if (strlen(trimSpace(semi + 1)) > MAX_LEN - 1) {
+				dprintf(err, "dag: %s:%d: command is longer than %d characters\n", name, lineNum, MAX_LEN - 1);
+				break;
+			}
+			if (trimSpace(semi + 1)[0] != '\0') {
+				n->line = strdup(trimSpace(semi + 1));
+			}
+		}
+
+		for (dep = strtok_r(colon + 1, " \t", &saveptr); dep != NULL; dep = strtok_r(NULL, " \t", &saveptr)) {
+			if (n->depNum == DAG_DEPS) {
+				break;
+			}
+			n->deps[n->depNum++] = strdup(dep);
+		}
+		if (dep != NULL) {
+			dprintf(err, "dag: %s:%d: more than %d dependencies\n", name, lineNum, DAG_DEPS);
+			break;
+		}
+	}
+
+	if (len != -1) { // stopped at a bad line
+		freeGraph(nodes, *num);
+		nodes = NULL;
+	}
+	else if (nodes == NULL) {
+		nodes = malloc(sizeof(struct node));
+	}
+	free(text);
+	return nodes;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  waitingOn
+* -------------
+*  Finds a dependency of a target that linkGraph() could not put in
+*  order, which every target left over has.
+*
+* -------------
+*
+*  n: a pointer to the node struct of a target left over
+*
+*  left: an array of ints with the number of dependencies of each
+*		target not yet in the order
+*
+*  Returns the index of the dependency.
+*
+*---------------------------------------------------------------------*/
+int waitingOn(struct node* n, int* left) {
+	int j;
+
+	for (j = 0; n->depNode[j] == -1 || left[n->depNode[j]] == 0; j++);
+	return n->depNode[j];
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  linkGraph
+* -------------
+*  Connects each target to its dependencies and users and puts the
+*  targets in an order where every target comes after its
+*  dependencies.
+*
+* -------------
+*
+*  nodes, num: see freeGraph()
+*
+*  err: an int that is the file descriptor to write errors to
+*
+*  Returns an array of num ints with the indexes of the targets in
+*  that order, or NULL and prints a message if a target is named
+*  twice or the graph has a cycle.
+*
+*---------------------------------------------------------------------*/
+int* linkGraph(struct node* nodes, int num, int err) {
+	struct named* sorted = malloc((num + 1) * sizeof(struct named));
+	struct named key;
+	struct named* found;
+	int* order = malloc((num + 1) * sizeof(int));
+	int* left = malloc((num + 1) * sizeof(int)); // dependencies not yet in the order
+	int ordered = 0;
+	int i;
+	int j;
+
+	for (i = 0; i < num; i++) {
+		sorted[i].name = nodes[i].target;
+		sorted[i].index = i;
+	}
+	qsort(sorted, num, sizeof(struct named), &compareNamed);
+	for (i = 1; i < num; i++) {
+		if (strcmp(sorted[i - 1].name, sorted[i].name) == 0) {
+			dprintf(err, "dag: %s is a target twice\n", sorted[i].name);
+			free(sorted);
+			free(order);
+			free(left);
+			return NULL;
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		for (j = 0; j < nodes[i].depNum; j++) {
+			key.name = nodes[i].deps[j];
+			found = bsearch(&key, sorted, num, sizeof(struct named), &compareNamed);
+			nodes[i].depNode[j] = (found != NULL) ? found->index : -1;
+			if (found != NULL) {
+				nodes[found->index].userNum++;
+				nodes[i].waiting++;
+			}
+		}
+	}
+	for (i = 0; i < num; i++) {
+		nodes[i].users = malloc((nodes[i].userNum + 1) * sizeof(int));
+		nodes[i].userNum = 0;
+		left[i] = nodes[i].waiting;
+		if (left[i] == 0) {
+			order[ordered++] = i;
+		}
+	}
+	for (i = 0; i < num; i++) {
+		for (j = 0; j < nodes[i].depNum; j++) {
+			if (nodes[i].depNode[j] != -1) {
+				struct node* dep = &nodes[nodes[i].depNode[j]];
+				dep->users[dep->userNum++] = i;
+			}
+		}
+	}
+
+	for (i = 0; i < ordered; i++) { // Kahn's algorithm, anything left over is on a cycle
+		struct node* n = &nodes[order[i]];
+		for (j = 0; j < n->userNum; j++) {
+			if (--left[n->users[j]] == 0) {
+				order[ordered++] = n->users[j];
+			}
+		}
+	}
+	if (ordered < num) {
+		// every target left over waits on another one, so following them has to come back around
+		char* seen = calloc(num, sizeof(char));
+		int start;
+
+		for (i = 0; left[i] == 0; i++);
+		while (!seen[i]) {
+			seen[i] = 1;
+			i = waitingOn(&nodes[i], left);
+		}
+		start = i;
+		dprintf(err, "dag: dependency cycle: %s", nodes[start].target);
+		do {
+			i = waitingOn(&nodes[i], left);
+			dprintf(err, " -> %s", nodes[i].target);
+		} while (i != start);
+		dprintf(err, "\n");
+		free(seen);
+		free(order);
+		order = NULL;
+	}
+
+	free(sorted);
+	free(left);
+	return order;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  isNewer
+* -------------
+*  Checks if one modification time is later than another.
+*
+* -------------
+*
+*  a, b: pointers to timespec structs
+*
+*  Returns 1 if a is later than b, 0 otherwise.
+*
+*---------------------------------------------------------------------*/
+int isNewer(struct timespec* a, struct timespec* b) {
+	return a->tv_sec > b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec > b->tv_nsec);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  upToDate
+* -------------
+*  Checks if a target's file is newer than every dependency, and no
+*  dependency was made again during this run.
+*
+* -------------
+*
+*  nodes: an array of node structs
+*
+*  i: an int that is the index of the target
+*
+*  err: an int that is the file descriptor to write errors to
+*
+*  Returns 1 if the target is up to date, 0 if it has to be made, or
+*  -1 and prints a message if a dependency is neither a target nor an
+*  existing file.
+*
+*---------------------------------------------------------------------*/
+int upToDate(struct node* nodes, int i, int err) {
+	struct node* n = &nodes[i];
+	struct stat made;
+	struct stat dep;
+	int exists = (stat(n->target, &made) == 0);
+	int current = exists;
+	int j;
+
+	for (j = 0; j < n->depNum; j++) {
+		if (n->depNode[j] != -1 && nodes[n->depNode[j]].state == NODE_RAN) {
+			current = 0;
+		}
+		else if (stat(n->deps[j], &dep) == 0) {
+			if (exists && isNewer(&dep.st_mtim, &made.st_mtim)) {
+				current = 0;
+			}
+		}
+		else if (n->depNode[j] == -1) {
+			dprintf(err, "dag: %s: no target or file %s\n", n->target, n->deps[j]);
+			return -1;
+		}
+	}
+	return current;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  finishNode
+* -------------
+*  Records how a target ended. Users whose last dependency this was are
+*  added to the queue of targets ready to start, or if the target
+*  failed, every target that depends on it is blocked.
+*
+* -------------
+*
+*  nodes: an array of node structs
+*
+*  i: an int that is the index of the target
+*
+*  state: an int, one of the NODE_ codes that end a target
+*
+*  queue: an array of ints that ready targets are added to
+*
+*  queued: a pointer to an int that is the length of the queue
+*
+*  finished: a pointer to an int that counts the ended targets
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void finishNode(struct node* nodes, int i, int state, int* queue, int* queued, int* finished) {
+	struct node* n = &nodes[i];
+	int j;
+
+	n->state = state;
+	(*finished)++;
+	for (j = 0; j < n->userNum; j++) {
+		struct node* user = &nodes[n->users[j]];
+		if (user->state != NODE_WAITING) {
+			continue;
+		}
+		if (state == NODE_FAILED || state == NODE_BLOCKED) {
+			finishNode(nodes, n->users[j], NODE_BLOCKED, queue, queued, finished);
+		}
+		else if (--user->waiting == 0) {
+			queue[(*queued)++] = n->users[j];
+		}
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  startNode
+* -------------
+*  Starts the command of a target without waiting for it.
+*
+* -------------
+*
+*  n: a pointer to the node struct of the target
+*
+*  io: a pointer to the builtinIO struct of the dag command
+*
+*  Returns 1 if the command started, returns 0 and prints a message
+*  otherwise.
+*
+*---------------------------------------------------------------------*/
+int startNode(struct node* n, struct builtinIO* io) {
+	char line[MAX_LEN];
+	struct command* c;
+
+	strcpy(line, n->line);
+	c = parseCommand(line);
+	if (c->name[0] == '\0') { // only assignments or redirections, which would run cat on dag's input
+		dprintf(io->err, "dag: %s: a command line with no command cannot run in a graph\n", n->target);
+		freeCommand(c);
+		return 0;
+	}
+	if (findBuiltin(c->name) != NULL) {
+		dprintf(io->err, "dag: %s: built in commands cannot run in a graph\n", n->target);
+		freeCommand(c);
+		return 0;
+	}
+
+	dprintf(io->out, "[%s] %s\n", n->target, n->line);
+	n->started = nowMicros();
+	n->pid = dagSpawn(c, n->helpers, &n->helperNum);
+	if (n->pid == -1) {
+		statSpawnFailed();
+		for (int i = 0; i < n->helperNum; i++) {
+			waitpid(n->helpers[i], NULL, 0);
+		}
+		freeCommand(c);
+		return 0;
+	}
+	statStart(n->pid, c);
+	n->pidfd = pidfd_open(n->pid, 0);
+	freeCommand(c);
+	return 1;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  reapNode
+* -------------
+*  Checks if the command of a running target has exited, and reaps it
+*  and its helpers if so.
+*
+* -------------
+*
+*  n: a pointer to the node struct of the target
+*
+*  io: a pointer to the builtinIO struct of the dag command
+*
+*  Returns NODE_RUNNING if the command is still running, otherwise
+*  NODE_RAN if it succeeded or NODE_FAILED and prints its status.
+*
+*---------------------------------------------------------------------*/
+int reapNode(struct node* n, struct builtinIO* io) {
+	int childStatus;
+	int i;
+
+	if (waitpid(n->pid, &childStatus, WNOHANG) <= 0) {
+		return NODE_RUNNING;
+	}
+	n->duration = nowMicros() - n->started;
+	statFinish(n->pid, childStatus, NULL);
+	for (i = 0; i < n->helperNum; i++) {
+		waitpid(n->helpers[i], NULL, 0); // they finish once the command's pipes close
+	}
+	if (n->pidfd != -1) {
+		close(n->pidfd);
+		n->pidfd = -1;
+	}
+
+	if (WIFEXITED(childStatus) && WEXITSTATUS(childStatus) == 0) {
+		return NODE_RAN;
+	}
+	if (WIFEXITED(childStatus)) {
+		dprintf(io->err, "dag: %s failed: exit value %d\n", n->target, WEXITSTATUS(childStatus));
+	}
+	else {
+		dprintf(io->err, "dag: %s failed: terminated by signal %d\n", n->target, WTERMSIG(childStatus));
+	}
+	return NODE_FAILED;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  printReport
+* -------------
+*  Prints how many targets ended each way, how busy the jobs were and
+*  the critical path, the chain of dependencies with the longest total
+*  run time.
+*
+* -------------
+*
+*  nodes, num: see freeGraph()
+*
+*  order: an array of num ints with dependencies before their users
+*
+*  elapsed: a long that is how long the graph took, in microseconds
+*
+*  jobs: an int that is the most commands allowed to run at once
+*
+*  out: an int that is the file descriptor to write the report to
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void printReport(struct node* nodes, int num, int* order, long elapsed, int jobs, int out) {
+	int counts[NODE_BLOCKED + 1] = { 0 };
+	int* chain = malloc((num + 1) * sizeof(int));
+	int chainNum = 0;
+	long busy = 0;
+	int last = -1;
+	int i;
+	int j;
+
+	for (i = 0; i < num; i++) {
+		struct node* n = &nodes[order[i]];
+		counts[n->state]++;
+		busy += n->duration;
+		n->path = 0;
+		for (j = 0; j < n->depNum; j++) {
+			if (n->depNode[j] != -1 && nodes[n->depNode[j]].path > n->path) {
+				n->path = nodes[n->depNode[j]].path;
+				n->pathPrev = n->depNode[j];
+			}
+		}
+		n->path += n->duration;
+		if (last == -1 || n->path > nodes[last].path) {
+			last = order[i];
+		}
+	}
+
+	dprintf(out, "dag: %d targets: %d ran, %d up to date, %d failed, %d not run\n", num,
+		counts[NODE_RAN], counts[NODE_CURRENT], counts[NODE_FAILED],
+		counts[NODE_WAITING] + counts[NODE_RUNNING] + counts[NODE_BLOCKED]);
+	dprintf(out, "dag: %.3f s elapsed, %.3f s of commands over %d jobs, %.1fx parallel\n", elapsed / 1e6,
+		busy / 1e6, jobs, elapsed > 0 ? (double) busy / elapsed : 0.0);
+
+	if (last == -1 || nodes[last].path == 0) {
+		free(chain);
+		return;
+	}
+	for (i = last; i != -1; i = nodes[i].pathPrev) {
+		if (nodes[i].duration > 0) {
+			chain[chainNum++] = i;
+		}
+	}
+	dprintf(out, "dag: critical path %.3f s:\n", nodes[last].path / 1e6);
+	for (i = chainNum - 1; i >= 0; i--) {
+		dprintf(out, "\t%8.3f s  %s\n", nodes[chain[i]].duration / 1e6, nodes[chain[i]].target);
+	}
+	free(chain);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInDag
+* -------------
+*  Code for the built in dag command, "dag [-j JOBS] [FILE]", which runs
+*  the graph in FILE, or read from input if no FILE is given, with at
+*  most JOBS commands at once. JOBS defaults to the number of CPUs.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if every target is made or up to date, returns 1 and
+*  prints a message otherwise.
+*
+*---------------------------------------------------------------------*/
+int builtInDag(int argc, char* argv[], struct builtinIO* io) {
+	struct sigaction interrupt = { 0 };
+	struct node* nodes;
+	FILE* stream;
+	char* name = "input";
+	int num;
+	int* order;
+	int* queue;
+	int queued = 0;
+	int next = 0; // next target in the queue to start
+	int* slots; // target running in each slot, or -1
+	struct pollfd* fds;
+	int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	int running = 0;
+	int finished = 0;
+	int failed = 0;
+	int arg = 1;
+	int ioFD[3] = { io->in, io->out, io->err };
+	int saved[3] = { -1, -1, -1 }; // the shell's own stdin, stdout and stderr while they are moved
+	long begin;
+	int i;
+
+	if (arg + 1 < argc && strcmp(argv[arg], "-j") == 0) {
+		jobs = atoi(argv[arg + 1]);
+		arg += 2;
+	}
+	if (argc > arg + 1 || jobs < 1) {
+		dprintf(io->err, "usage: dag [-j JOBS] [FILE]\n");
+		return 1;
+	}
+	if (arg < argc) {
+		name = argv[arg];
+		stream = fopen(name, "r");
+	}
+	else {
+		stream = fdopen(dup(io->in), "r");
+	}
+	if (stream == NULL) {
+		dprintf(io->err, "dag: %s: %s\n", name, strerror(errno));
+		return 1;
+	}
+	nodes = readGraph(stream, name, &num, io->err);
+	fclose(stream);
+	if (nodes == NULL) {
+		return 1;
+	}
+	order = linkGraph(nodes, num, io->err);
+	if (order == NULL) {
+		freeGraph(nodes, num);
+		return 1;
+	}
+
+	queue = malloc((num + 1) * sizeof(int));
+	slots = malloc(jobs * sizeof(int));
+	fds = malloc(jobs * sizeof(struct pollfd));
+	for (i = 0; i < jobs; i++) {
+		slots[i] = -1;
+	}
+	for (i = 0; i < num; i++) {
+		if (nodes[i].waiting == 0) {
+			queue[queued++] = i;
+		}
+	}
+
+	// SIGINT reaches the commands too, so stop starting new ones and let the rest end
+	dagInterrupted = 0;
+	interrupt.sa_handler = &dagSIGINT;
+	sigaction(SIGINT, &interrupt, NULL);
+	for (i = 0; i < 3; i++) { // commands read and write where dag does
+		if (ioFD[i] != i) {
+			fflush((i == 1) ? stdout : stderr);
+			saved[i] = dup(i);
+			dup2(ioFD[i], i);
+		}
+	}
+
+	begin = nowMicros();
+	while (finished < num) {
+		int nfds = 0;
+		int polling = 1; // 0 if a command has no pidfd and has to be checked every so often
+
+		// start ready targets while there are free slots
+		while (!dagInterrupted && next < queued && running < jobs) {
+			int t = queue[next++];
+			int current = (nodes[t].line != NULL) ? upToDate(nodes, t, io->err) : 1;
+
+			if (nodes[t].line == NULL) { // groups pass on whether their dependencies ran
+				for (i = 0; i < nodes[t].depNum; i++) {
+					if (nodes[t].depNode[i] != -1 && nodes[nodes[t].depNode[i]].state == NODE_RAN) {
+						current = 0;
+					}
+				}
+				finishNode(nodes, t, current ? NODE_CURRENT : NODE_RAN, queue, &queued, &finished);
+			}
+			else if (current == 1) {
+				finishNode(nodes, t, NODE_CURRENT, queue, &queued, &finished);
+			}
+			else if (current == -1 || !startNode(&nodes[t], io)) {
+				finishNode(nodes, t, NODE_FAILED, queue, &queued, &finished);
+			}
+			else {
+				nodes[t].state = NODE_RUNNING;
+				for (i = 0; slots[i] != -1; i++);
+				slots[i] = t;
+				running++;
+			}
+		}
+		if (running == 0) { // nothing left that can start
+			break;
+		}
+
+		// sleep until a command exits
+		for (i = 0; i < jobs; i++) {
+			if (slots[i] != -1 && nodes[slots[i]].pidfd != -1) {
+				fds[nfds].fd = nodes[slots[i]].pidfd;
+				fds[nfds++].events = POLLIN;
+			}
+			else if (slots[i] != -1) {
+				polling = 0;
+			}
+		}
+		if (poll(fds, nfds, polling ? -1 : 10) == -1 && errno != EINTR) {
+			perror("dag poll()");
+			break;
+		}
+
+		for (i = 0; i < jobs; i++) {
+			int state = (slots[i] != -1) ? reapNode(&nodes[slots[i]], io) : NODE_RUNNING;
+			if (state != NODE_RUNNING) {
+				finishNode(nodes, slots[i], state, queue, &queued, &finished);
+				slots[i] = -1;
+				running--;
+			}
+		}
+	}
+
+	for (i = 0; i < jobs; i++) { // only left running if poll() failed
+		if (slots[i] != -1) {
+			waitpid(nodes[slots[i]].pid, NULL, 0);
+		}
+	}
+	for (i = 0; i < 3; i++) {
+		if (saved[i] != -1) {
+			dup2(saved[i], i);
+			close(saved[i]);
+		}
+	}
+	signal(SIGINT, SIG_IGN);
+
+	printReport(nodes, num, order, nowMicros() - begin, jobs, io->out);
+	for (i = 0; i < num; i++) {
+		if (nodes[i].state != NODE_RAN && nodes[i].state != NODE_CURRENT) {
+			failed = 1;
+		}
+	}
+
+	free(queue);
+	free(slots);
+	free(fds);
+	free(order);
+	freeGraph(nodes, num);
+
+	return failed;
+}
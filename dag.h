@@ -0,0 +1,32 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for the dag built in command, which runs a graph of commands
+* in dependency order, as many at once as the graph and the job limit allow. Each line of the
+* graph names a target, the targets or files it depends on, and the command that makes it:
+*
+*	target: dep1 dep2 ; command args
+*
+* Blank lines and lines starting with # are skipped, and a target without a command only groups
+* its dependencies. A target that is a file newer than all of its dependencies is up to date and
+* is not run again, like make. When a command fails, everything that depends on it is not run but
+* the rest of the graph carries on. Commands read and write wherever dag itself does, like
+* foreground commands, and the report at the end shows the critical path, the chain of commands
+* that decided how long the whole graph took.
+*/
+
+#ifndef DAG_H
+#define DAG_H
+
+#include <sys/types.h>
+
+#include "command.h"
+
+
+#define DAG_DEPS 64 // most dependencies of one target
+
+
+extern pid_t (*dagSpawn)(struct command*, pid_t*, int*); // starts a command without waiting, set by the shell
+
+#endif
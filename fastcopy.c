@@ -0,0 +1,548 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for the in-process copy fast path. Copying a file with cat or cp
+* normally costs a fork and an exec for a program that just moves bytes from one file to another,
+* so the shell recognizes those command lines and copies the data itself inside the kernel.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "fastcopy.h"
+
+
+volatile sig_atomic_t copyInterrupted = 0; // set by SIGINT while the shell is copying
+
+
+/*----------------------------------------------------------------------
+*
+*  copySIGINT
+* -------------
+*  Signal handler for SIGINT while the shell is copying, which stops
+*  the copy the way SIGINT would stop cat or cp.
+*
+* -------------
+*
+*  signum: int that represents the type of signal handled
+*
+*  Returns nothing, but sets copyInterrupted.
+*
+*---------------------------------------------------------------------*/
+void copySIGINT(int signum) {
+	copyInterrupted = 1;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  writeAll
+* -------------
+*  Writes a whole buffer to a file descriptor.
+*
+* -------------
+*
+*  out: an int that is the file descriptor to write to
+*
+*  buffer: a pointer (const char*) to the bytes to write
+*
+*  len: a size_t that is the number of bytes to write
+*
+*  Returns 0 if successful, -1 with errno set otherwise.
+*
+*---------------------------------------------------------------------*/
+int writeAll(int out, const char* buffer, size_t len) {
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(out, buffer, len);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n == -1) {
+			return -1;
+		}
+		buffer += n;
+		len -= n;
+	}
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  pumpChunk
+* -------------
+*  Copies up to max bytes with read() and write(), for files that none
+*  of the in-kernel calls accept.
+*
+* -------------
+*
+*  in, out: ints that are the file descriptors to copy between
+*
+*  max: a size_t that is the most bytes to copy
+*
+*  Returns the number of bytes copied, 0 at the end of the input, or -1
+*  with errno set.
+*
+*---------------------------------------------------------------------*/
+ssize_t pumpChunk(int in, int out, size_t max) {
+	char buffer[65536];
+	ssize_t n;
+
+	n = read(in, buffer, max < sizeof(buffer) ? max : sizeof(buffer));
+	if (n > 0 && writeAll(out, buffer, n) == -1) {
+		return -1;
+	}
+	return n;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  spliceChunk
+* -------------
+*  Copies up to COPY_CHUNK bytes with splice(). splice() needs a pipe
+*  on one side, so when neither file is a pipe the data goes through
+*  a bridge pipe that is made on the first call.
+*
+* -------------
+*
+*  in, out: ints that are the file descriptors to copy between
+*
+*  bridge: an array of two ints holding the bridge pipe, or -1 if it
+*			has not been made yet
+*
+*  Returns the number of bytes copied, 0 at the end of the input, or -1
+*  with errno set.
+*
+*---------------------------------------------------------------------*/
+ssize_t spliceChunk(int in, int out, int* bridge) {
+	ssize_t n;
+	ssize_t left;
+	ssize_t m;
+
+	if (bridge[0] == -1) {
+		n = splice(in, NULL, out, NULL, COPY_CHUNK, SPLICE_F_MOVE);
+		if (n != -1 || errno != EINVAL) {
+			return n;
+		}
+		if (pipe2(bridge, O_CLOEXEC) == -1) {
+			errno = EINVAL; // moves on to read() and write()
+			return -1;
+		}
+	}
+
+	n = splice(in, NULL, bridge[1], NULL, COPY_CHUNK, SPLICE_F_MOVE);
+	for (left = n; left > 0; left -= m) {
+		m = splice(bridge[0], NULL, out, NULL, left, SPLICE_F_MOVE);
+		if (m == -1 && errno == EINVAL) { // the output takes no splice(), empty the bridge by hand
+			m = pumpChunk(bridge[0], out, left);
+		}
+		if (m == -1 && errno != EINTR) {
+			return -1;
+		}
+		if (m == -1) {
+			m = 0;
+		}
+	}
+	return n;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  copyData
+* -------------
+*  Copies everything from one file descriptor to another inside the
+*  kernel. Tries copy_file_range(), which can share blocks on file
+*  systems with reflinks, then sendfile(), then splice(), and finally
+*  read() and write(), moving on whenever one does not support the
+*  kinds of files given.
+*
+* -------------
+*
+*  in: an int that is the file descriptor to read from
+*
+*  out: an int that is the file descriptor to write to
+*
+*  Returns 0 if successful, returns -1 with errno set if a copy failed
+*  or 1 if it was interupted by SIGINT.
+*
+*---------------------------------------------------------------------*/
+int copyData(int in, int out) {
+	int method = 0; // 0 = copy_file_range, 1 = sendfile, 2 = splice, 3 = read and write
+	int bridge[2] = { -1, -1 };
+	int result = 0;
+	ssize_t n;
+
+	while (!copyInterrupted) {
+		switch (method) {
+		case 0:
+			n = copy_file_range(in, NULL, out, NULL, COPY_CHUNK, 0);
+			break;
+		case 1:
+			n = sendfile(out, in, NULL, COPY_CHUNK);
+			break;
+		case 2:
+			n = spliceChunk(in, out, bridge);
+			break;
+		default:
+			n = pumpChunk(in, out, COPY_CHUNK);
+		}
+
+		if (n == 0) { // end of the input
+			break;
+		}
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n == -1 && method < 3 && (errno == EINVAL || errno == EXDEV || errno == ENOSYS
+			|| errno == EOPNOTSUPP || errno == EBADF || errno == ESPIPE)) {
+			method++; // these files need the next way of copying, which carries on from the current offsets
+			continue;
+		}
+		if (n == -1) {
+			result = -1;
+			break;
+		}
+	}
+
+	if (bridge[0] != -1) {
+		n = errno;
+		close(bridge[0]);
+		close(bridge[1]);
+		errno = n;
+	}
+	if (result == 0 && copyInterrupted) {
+		result = 1;
+	}
+	return result;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  openTarget
+* -------------
+*  Opens an output file of a command the same way outputRedirect()
+*  does. Files that are appended to are opened without O_APPEND and
+*  positioned at their end instead, since copy_file_range(), sendfile()
+*  and splice() all refuse O_APPEND files.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address of the file
+*
+*  append: an int, 1 if the output is added to the end of the file
+*
+*  Returns the file descriptor, or -1 and prints a message with the
+*  error.
+*
+*---------------------------------------------------------------------*/
+int openTarget(char* path, int append) {
+	int targetFD = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC), 0640);
+
+	if (targetFD == -1) {
+		perror("output open()");
+		return -1;
+	}
+	if (append) {
+		lseek(targetFD, 0, SEEK_END);
+	}
+	return targetFD;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  sameFile
+* -------------
+*  Checks if an open file descriptor is a given file.
+*
+* -------------
+*
+*  fd: an int that is the open file descriptor
+*
+*  other: a pointer to the stat struct of the other file
+*
+*  Returns 1 if they are the same file, 0 otherwise.
+*
+*---------------------------------------------------------------------*/
+int sameFile(int fd, struct stat* other) {
+	struct stat info;
+
+	return fstat(fd, &info) == 0 && info.st_dev == other->st_dev && info.st_ino == other->st_ino;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  copyRedirects
+* -------------
+*  Runs a line with no command name or cat with only redirections. The
+*  input file or here-document is copied to each output file, or to
+*  stdout if there are none. An input that cannot be read twice, such
+*  as a FIFO, is copied to the first output and later outputs copy
+*  from there. A line with no command and no input just creates or
+*  truncates its output files. Like cat, an output that is the input
+*  file itself is refused, since the copy would keep reading what it
+*  had just written and never end.
+*
+* -------------
+*
+*  c: a command struct that is to be executed
+*
+*  Returns the exit value the command would have had, or -1 if it was
+*  interupted by SIGINT.
+*
+*---------------------------------------------------------------------*/
+int copyRedirects(struct command* c) {
+	char* who = (c->name[0] == '\0') ? "smallsh" : c->name;
+	struct stat sourceStat;
+	int sourceFD = -1;
+	off_t sourceStart = 0;
+	off_t firstStart = 0; // where the copy starts in the first output, after what it already had if appended
+	int targetFD;
+	int targets = (c->outNum > 0) ? c->outNum : 1;
+	int result = 0;
+	int i;
+
+	if (c->input != NULL) {
+		sourceFD = open(c->input, O_RDONLY | O_CLOEXEC);
+		if (sourceFD == -1) {
+			printf("cannot open %s for input\n", c->input);
+			fflush(stdout);
+			return 1;
+		}
+		fstat(sourceFD, &sourceStat);
+	}
+
+	if (c->errOutput != NULL) { // nothing to write there, but it is still created
+		if ((targetFD = openTarget(c->errOutput, c->errAppend)) == -1) {
+			result = 1;
+		}
+		else {
+			close(targetFD);
+		}
+	}
+
+	fflush(stdout); // keep the order of anything the shell printed before the copy
+	for (i = 0; i < targets && result == 0; i++) {
+		if (c->outNum == 0) {
+			targetFD = STDOUT_FILENO;
+		}
+		else if ((targetFD = openTarget(c->output[i], c->append[i])) == -1) {
+			result = 1;
+			break;
+		}
+
+		if (sourceFD != -1 && sameFile(targetFD, &sourceStat)) {
+			fprintf(stderr, "%s: %s: input file is output file\n", who, c->input);
+			result = 1;
+		}
+		else if (sourceFD != -1) {
+			if (i == 0) {
+				firstStart = lseek(targetFD, 0, SEEK_CUR);
+			}
+			else if (lseek(sourceFD, sourceStart, SEEK_SET) == -1) { // a pipe can only be read once, so copy the first output instead
+				close(sourceFD);
+				sourceStart = firstStart;
+				sourceFD = open(c->output[0], O_RDONLY | O_CLOEXEC);
+				if (sourceFD == -1 || lseek(sourceFD, sourceStart, SEEK_SET) == -1 || fstat(sourceFD, &sourceStat) == -1) {
+					result = -1;
+				}
+				else if (sameFile(targetFD, &sourceStat)) {
+					fprintf(stderr, "%s: %s: input file is output file\n", who, c->output[0]);
+					result = 1;
+				}
+			}
+			if (result == 0 && (result = copyData(sourceFD, targetFD)) == -1) {
+				result = -1;
+			}
+			if (result == -1) {
+				fprintf(stderr, "%s: %s\n", who, strerror(errno));
+				result = 1;
+			}
+		}
+		else if (c->hereBody != NULL && writeAll(targetFD, c->hereBody, strlen(c->hereBody)) == -1) {
+			fprintf(stderr, "%s: %s\n", who, strerror(errno));
+			result = 1;
+		}
+
+		if (targetFD != STDOUT_FILENO) {
+			close(targetFD);
+		}
+	}
+
+	if (sourceFD != -1) {
+		close(sourceFD);
+	}
+	return (result == 1 && copyInterrupted) ? -1 : result;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  copyFile
+* -------------
+*  Runs "cp src dst" with the same messages and exit values as cp. If
+*  dst is a directory the copy goes inside it, and a new file gets the
+*  permissions of src.
+*
+* -------------
+*
+*  src: a string (char*) that contains the address of the file to copy
+*
+*  dst: a string (char*) that contains the address to copy it to
+*
+*  Returns the exit value cp would have had, -1 if it was interupted by
+*  SIGINT, or -2 if src is not a regular file or directory, which is
+*  left to the real cp.
+*
+*---------------------------------------------------------------------*/
+int copyFile(char* src, char* dst) {
+	struct stat srcStat;
+	struct stat dstStat;
+	char path[MAX_LEN];
+	char* base;
+	int sourceFD;
+	int targetFD;
+	int result;
+
+	if (stat(src, &srcStat) == -1) {
+		fprintf(stderr, "cp: cannot stat '%s': %s\n", src, strerror(errno));
+		return 1;
+	}
+	if (S_ISDIR(srcStat.st_mode)) {
+		fprintf(stderr, "cp: -r not specified; omitting directory '%s'\n", src);
+		return 1;
+	}
+	if (!S_ISREG(srcStat.st_mode)) {
+		return -2;
+	}
+
+	snprintf(path, MAX_LEN, "%s", dst);
+	if (stat(path, &dstStat) == 0 && S_ISDIR(dstStat.st_mode)) { // copy into the directory
+		base = strrchr(src, '/');
+		snprintf(path, MAX_LEN, "%s/%s", dst, (base != NULL) ? base + 1 : src);
+	}
+	if (stat(path, &dstStat) == 0 && dstStat.st_dev == srcStat.st_dev && dstStat.st_ino == srcStat.st_ino) {
+		fprintf(stderr, "cp: '%s' and '%s' are the same file\n", src, path);
+		return 1;
+	}
+
+	sourceFD = open(src, O_RDONLY | O_CLOEXEC);
+	if (sourceFD == -1) {
+		fprintf(stderr, "cp: cannot open '%s' for reading: %s\n", src, strerror(errno));
+		return 1;
+	}
+	targetFD = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, srcStat.st_mode & 07777);
+	if (targetFD == -1) {
+		fprintf(stderr, "cp: cannot create regular file '%s': %s\n", path, strerror(errno));
+		close(sourceFD);
+		return 1;
+	}
+
+	result = copyData(sourceFD, targetFD);
+	if (result == -1) {
+		fprintf(stderr, "cp: error copying '%s' to '%s': %s\n", src, path, strerror(errno));
+		result = 1;
+	}
+	else if (result == 1) {
+		result = -1;
+	}
+
+	close(sourceFD);
+	close(targetFD);
+	return result;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  fastCopy
+* -------------
+*  Runs a foreground command inside the shell if it only copies data.
+*  Handles three forms:
+*		< in > out		a line with no command name, which copies the
+*						input to every output or just creates them
+*		cat < in [> out]	cat with no arguments besides redirections
+*		cp src dst		cp of one regular file with no options
+*
+* -------------
+*
+*  c: a command struct that is to be executed
+*
+*  status: a string (char*) that contains the status of the last
+*			foreground command, which is overwritten the way the
+*			external command would have set it
+*
+*  Returns 1 if the command was run, returns 0 if it is not one of the
+*  forms above and must be run normally.
+*
+*---------------------------------------------------------------------*/
+int fastCopy(struct command* c, char* status) {
+	struct sigaction interrupt = { 0 };
+	int exitValue;
+
+	if (c->name[0] == '\0') {
+		if (c->substNum > 0) { // helpers such as <z feed a real cat instead, see execCommand()
+			return 0;
+		}
+	}
+	else if (c->errOutput != NULL || c->errToOut) { // errors are left to the real command
+		return 0;
+	}
+	else if (strcmp(c->name, "cat") == 0) {
+		if (c->args[1] != NULL || c->outNum > 1 || c->substNum > 0 || (c->input == NULL && c->hereBody == NULL)) {
+			return 0;
+		}
+	}
+	else if (strcmp(c->name, "cp") == 0) {
+		if (c->args[1] == NULL || c->args[2] == NULL || c->args[3] != NULL || c->args[1][0] == '-'
+			|| c->args[2][0] == '-' || c->input != NULL || c->hereBody != NULL || c->outNum > 0 || c->substNum > 0) {
+			return 0;
+		}
+	}
+	else {
+		return 0;
+	}
+
+	// SIGINT stops the copy instead of being ignored, like it would stop the real command
+	copyInterrupted = 0;
+	interrupt.sa_handler = &copySIGINT;
+	sigaction(SIGINT, &interrupt, NULL);
+
+	if (strcmp(c->name, "cp") == 0) {
+		exitValue = copyFile(c->args[1], c->args[2]);
+	}
+	else {
+		exitValue = copyRedirects(c);
+	}
+
+	signal(SIGINT, SIG_IGN);
+
+	if (exitValue == -2) {
+		return 0;
+	}
+	if (exitValue == -1) {
+		sprintf(status, "terminated by signal %d", SIGINT);
+		printf("%s\n", status); // print the required termination message
+		fflush(stdout);
+		return 1;
+	}
+	sprintf(status, "exit value %d", exitValue);
+	return 1;
+}
@@ -0,0 +1,67 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for the in-process copy fast path. Command lines that only
+* copy data - a line with redirections and no command, cat with only redirections, and a plain
+* cp of one file - are run by the shell itself with copy_file_range() instead of forking.
+*/
+
+#ifndef FASTCOPY_H
+#define FASTCOPY_H
+
+#include "command.h"
+
+
+#define COPY_CHUNK 16777216 // bytes copied per system call, so SIGINT is noticed during big copies
+
+
+/*----------------------------------------------------------------------
+*
+*  copyData
+* -------------
+*  Copies everything from one file descriptor to another inside the
+*  kernel. Tries copy_file_range(), which can share blocks on file
+*  systems with reflinks, then sendfile(), then splice(), and finally
+*  read() and write(), moving on whenever one does not support the
+*  kinds of files given.
+*
+* -------------
+*
+*  in: an int that is the file descriptor to read from
+*
+*  out: an int that is the file descriptor to write to
+*
+*  Returns 0 if successful, returns -1 with errno set if a copy failed
+*  or 1 if it was interupted by SIGINT.
+*
+*---------------------------------------------------------------------*/
+int copyData(int in, int out);
+
+
+/*----------------------------------------------------------------------
+*
+*  fastCopy
+* -------------
+*  Runs a foreground command inside the shell if it only copies data.
+*  Handles three forms:
+*		< in > out		a line with no command name, which copies the
+*						input to every output or just creates them
+*		cat < in [> out]	cat with no arguments besides redirections
+*		cp src dst		cp of one regular file with no options
+*
+* -------------
+*
+*  c: a command struct that is to be executed
+*
+*  status: a string (char*) that contains the status of the last
+*			foreground command, which is overwritten the way the
+*			external command would have set it
+*
+*  Returns 1 if the command was run, returns 0 if it is not one of the
+*  forms above and must be run normally.
+*
+*---------------------------------------------------------------------*/
+int fastCopy(struct command* c, char* status);
+
+#endif
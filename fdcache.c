@@ -0,0 +1,386 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for the redirection cache used when running a script. Entries are
+* kept in a small array that is searched in order, which is faster than hashing at this size, and
+* the least recently used entry is replaced when the array is full.
+*
+* Every cached file has an inotify watch. Since the cache holds the file open, deleting it only
+* drops its link count, which inotify reports as IN_ATTRIB rather than IN_DELETE_SELF, so IN_ATTRIB
+* is watched too. The path can also start leading somewhere else when a directory on the way is
+* renamed or replaced, which the file's own watch never sees, so each directory the path passes
+* through is watched for changes to the one name the path uses in it. Events are read before
+* every lookup, which costs one non-blocking read(), and a hit needs no other system call to check
+* that it is still good.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "command.h"
+#include "fdcache.h"
+
+
+#define FILE_EVENTS (IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+#define DIR_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR)
+
+
+/*----------------------------------------------------------------------
+*
+*  struct cached
+* -------------
+*  Contains one open output file in the cache.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address as it was given on
+*			the command line, or NULL if the slot is empty
+*
+*  append: an int, 1 if the file was opened with O_APPEND
+*
+*  fd: an int that is the open file descriptor
+*
+*  watch: an int that is the inotify watch descriptor for the file -
+*			entries for the same file share one
+*
+*  names: a string (char*) that is a copy of path cut into one string
+*			per name in it
+*
+*  dirWatch: an array of ints that are the inotify watch descriptors of
+*			the directories the path passes through, starting with the
+*			working directory or /
+*
+*  dirName: an array of strings (char**) matching dirWatch, the name
+*			the path looks up in each directory, pointing into names
+*
+*  dirNum: an int that is the number of directories watched
+*
+*  used: an unsigned long that is the lookup count at the last use,
+*			for finding the least recently used entry
+*
+*---------------------------------------------------------------------*/
+struct cached {
+	char* path;
+	int append;
+	int fd;
+	int watch;
+	char* names;
+	int dirWatch[CACHE_DEPTH];
+	char* dirName[CACHE_DEPTH];
+	int dirNum;
+	unsigned long used;
+};
+
+
+struct cached cache[CACHE_SLOTS];
+int notifyFD = -1; // inotify instance, -1 while the cache is off
+unsigned long lookups = 0;
+
+
+/*----------------------------------------------------------------------
+*
+*  cacheOpen
+* -------------
+*  Turns on the redirection cache. Until it is called, cacheTarget()
+*  always returns -1 and redirections are opened by the child.
+*
+* -------------
+*
+*  Returns 0 if successful, returns -1 and prints a message with the
+*  error if inotify is not available.
+*
+*---------------------------------------------------------------------*/
+int cacheOpen() {
+	notifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifyFD == -1) {
+		perror("inotify_init1()");
+		return -1;
+	}
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  watchUsed
+* -------------
+*  Checks if an inotify watch is used by an entry other than the given
+*  one. inotify gives the same watch descriptor for the same file or
+*  directory, so entries often share them.
+*
+* -------------
+*
+*  watch: an int that is the watch descriptor
+*
+*  entry: a pointer to the cached struct to leave out
+*
+*  Returns 1 if another entry uses it, 0 otherwise.
+*
+*---------------------------------------------------------------------*/
+int watchUsed(int watch, struct cached* entry) {
+	int i;
+	int k;
+
+	for (i = 0; i < CACHE_SLOTS; i++) {
+		if (&cache[i] == entry || cache[i].path == NULL) {
+			continue;
+		}
+		if (cache[i].watch == watch) {
+			return 1;
+		}
+		for (k = 0; k < cache[i].dirNum; k++) {
+			if (cache[i].dirWatch[k] == watch) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  dropEntry
+* -------------
+*  Closes a cached file and empties its slot. Its inotify watches are
+*  only removed once no other entry uses them.
+*
+* -------------
+*
+*  entry: a pointer to the cached struct to empty
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void dropEntry(struct cached* entry) {
+	int k;
+
+	if (!watchUsed(entry->watch, entry)) {
+		inotify_rm_watch(notifyFD, entry->watch);
+	}
+	for (k = 0; k < entry->dirNum; k++) {
+		if (entry->dirWatch[k] != entry->watch && !watchUsed(entry->dirWatch[k], entry)) {
+			inotify_rm_watch(notifyFD, entry->dirWatch[k]); // fails harmlessly if the same one came up twice
+		}
+	}
+	close(entry->fd);
+	free(entry->path);
+	free(entry->names);
+	entry->path = NULL;
+	entry->names = NULL;
+	entry->dirNum = 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  watchPath
+* -------------
+*  Watches each directory a cached path passes through for changes to
+*  the name the path looks up there. For "a/b/out" that is "a" in the
+*  working directory, "b" in a and "out" in a/b.
+*
+* -------------
+*
+*  entry: a pointer to the cached struct, with path already set
+*
+*  Returns 0 if successful, returns -1 if a directory could not be
+*  watched or the path has more than CACHE_DEPTH names.
+*
+*---------------------------------------------------------------------*/
+int watchPath(struct cached* entry) {
+	char dir[MAX_LEN];
+	char* name;
+	char* end;
+	int len;
+
+	entry->names = strdup(entry->path);
+	entry->dirNum = 0;
+	name = entry->names;
+	while (*name == '/') {
+		name++;
+	}
+
+	while (*name != '\0') {
+		if (entry->dirNum == CACHE_DEPTH) {
+			return -1;
+		}
+		len = name - entry->names; // the directory is everything in the path before the name
+		if (len == 0) {
+			strcpy(dir, ".");
+		}
+		else {
+			memcpy(dir, entry->path, len);
+			dir[len] = '\0';
+		}
+		entry->dirWatch[entry->dirNum] = inotify_add_watch(notifyFD, dir, DIR_EVENTS);
+		if (entry->dirWatch[entry->dirNum] == -1) {
+			return -1;
+		}
+		entry->dirName[entry->dirNum++] = name;
+
+		end = strchr(name, '/');
+		if (end == NULL) {
+			break;
+		}
+		*end = '\0';
+		for (name = end + 1; *name == '/'; name++);
+	}
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  readEvents
+* -------------
+*  Reads any waiting inotify events and drops every entry whose file
+*  was renamed, deleted or had its attributes changed, or whose path
+*  now leads somewhere else.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void readEvents() {
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct inotify_event* event;
+	ssize_t len;
+	char* ptr;
+	int stale;
+	int i;
+	int k;
+
+	while ((len = read(notifyFD, buffer, sizeof(buffer))) > 0) {
+		for (ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + event->len) {
+			event = (struct inotify_event*)ptr;
+			if (event->mask & IN_IGNORED) { // watch is already gone
+				continue;
+			}
+			for (i = 0; i < CACHE_SLOTS; i++) {
+				if (cache[i].path == NULL) {
+					continue;
+				}
+				stale = (event->mask & IN_Q_OVERFLOW) || cache[i].watch == event->wd; // lost events could be about anything
+				for (k = 0; !stale && k < cache[i].dirNum; k++) {
+					stale = cache[i].dirWatch[k] == event->wd && (event->len == 0 || strcmp(event->name, cache[i].dirName[k]) == 0);
+				}
+				if (stale) {
+					dropEntry(&cache[i]);
+				}
+			}
+		}
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  cacheTarget
+* -------------
+*  Finds an output file in the cache, opening it and adding it in place
+*  of the least recently used one if it is not there. A file that is
+*  truncated by the redirection is truncated again on every use, just
+*  like opening it with O_TRUNC.
+*
+*  The file descriptor belongs to the cache and is closed on exec, so
+*  it must be dup2()'d by the child and never closed by the caller.
+*  Only foreground commands may use it - a later hit truncates and
+*  rewinds the shared offset, which would move a background job that
+*  is still writing through it.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address of the file
+*
+*  append: an int, 1 if the output is added to the end of the file
+*
+*  Returns the file descriptor, or -1 if the cache is off or the file
+*  could not be opened, in which case the child opens it as usual and
+*  reports the error.
+*
+*---------------------------------------------------------------------*/
+int cacheTarget(char* path, int append) {
+	struct cached* victim = &cache[0];
+	int fd;
+	int watch;
+	int i;
+
+	if (notifyFD == -1) {
+		return -1;
+	}
+	readEvents();
+	lookups++;
+
+	for (i = 0; i < CACHE_SLOTS; i++) {
+		if (cache[i].path != NULL && cache[i].append == append && strcmp(cache[i].path, path) == 0) {
+			cache[i].used = lookups;
+			if (!append) {
+				ftruncate(cache[i].fd, 0);
+				lseek(cache[i].fd, 0, SEEK_SET);
+			}
+			return cache[i].fd;
+		}
+		if (cache[i].path == NULL || (victim->path != NULL && cache[i].used < victim->used)) {
+			victim = &cache[i];
+		}
+	}
+
+	fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0640);
+	if (fd == -1) {
+		return -1;
+	}
+	watch = inotify_add_watch(notifyFD, path, FILE_EVENTS);
+	if (watch == -1) { // cannot tell when it changes, so do not keep it
+		close(fd);
+		return -1;
+	}
+
+	if (victim->path != NULL) {
+		dropEntry(victim);
+	}
+	victim->path = strdup(path);
+	victim->append = append;
+	victim->fd = fd;
+	victim->watch = watch;
+	victim->used = lookups;
+	if (watchPath(victim) == -1) { // cannot tell when the path changes, so do not keep it either
+		dropEntry(victim);
+		return -1;
+	}
+	return fd;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  cacheFlush
+* -------------
+*  Closes every file in the cache. Called when the working directory
+*  changes, since relative paths then point somewhere else.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void cacheFlush() {
+	int i;
+
+	if (notifyFD == -1) {
+		return;
+	}
+	for (i = 0; i < CACHE_SLOTS; i++) {
+		if (cache[i].path != NULL) {
+			dropEntry(&cache[i]);
+		}
+	}
+}
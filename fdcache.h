@@ -0,0 +1,79 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for the redirection cache used when running a script. The
+* shell keeps the output files of recent foreground commands open, so a script that redirects to
+* the same file over and over skips the path lookup and open() each time and children just dup2()
+* the cached file descriptor. inotify tells the cache when a file is renamed, deleted or changed,
+* or when a directory on its path is, so the next redirection opens the path again.
+*/
+
+#ifndef FDCACHE_H
+#define FDCACHE_H
+
+
+#define CACHE_SLOTS 16 // open output files kept by the cache
+#define CACHE_DEPTH 16 // most names in a cached path, each of whose directories is watched
+
+
+/*----------------------------------------------------------------------
+*
+*  cacheOpen
+* -------------
+*  Turns on the redirection cache. Until it is called, cacheTarget()
+*  always returns -1 and redirections are opened by the child.
+*
+* -------------
+*
+*  Returns 0 if successful, returns -1 and prints a message with the
+*  error if inotify is not available.
+*
+*---------------------------------------------------------------------*/
+int cacheOpen();
+
+
+/*----------------------------------------------------------------------
+*
+*  cacheTarget
+* -------------
+*  Finds an output file in the cache, opening it and adding it in place
+*  of the least recently used one if it is not there. A file that is
+*  truncated by the redirection is truncated again on every use, just
+*  like opening it with O_TRUNC.
+*
+*  The file descriptor belongs to the cache and is closed on exec, so
+*  it must be dup2()'d by the child and never closed by the caller.
+*  Only foreground commands may use it - a later hit truncates and
+*  rewinds the shared offset, which would move a background job that
+*  is still writing through it.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address of the file
+*
+*  append: an int, 1 if the output is added to the end of the file
+*
+*  Returns the file descriptor, or -1 if the cache is off or the file
+*  could not be opened, in which case the child opens it as usual and
+*  reports the error.
+*
+*---------------------------------------------------------------------*/
+int cacheTarget(char* path, int append);
+
+
+/*----------------------------------------------------------------------
+*
+*  cacheFlush
+* -------------
+*  Closes every file in the cache. Called when the working directory
+*  changes, since relative paths then point somewhere else.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void cacheFlush();
+
+#endif
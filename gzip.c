@@ -0,0 +1,152 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for the compressing redirections, which runs in the helper process
+* of a ">z" or "<z" redirection. zlib's gz functions do the buffering, so the helper only moves
+* data between the pipe to the command and the compressed file.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "gzip.h"
+
+
+int gzLevel = Z_DEFAULT_COMPRESSION;
+
+
+/*----------------------------------------------------------------------
+*
+*  runDeflate
+* -------------
+*  Compresses everything read from stdin into a gzip file until the
+*  write end of the pipe is closed.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address of the file to
+*			write, which is created or truncated
+*
+*  Returns 0 once all input has been written, returns 1 and prints a
+*  message with the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int runDeflate(char* path) {
+	char* buffer = malloc(GZ_BUFFER);
+	char mode[8];
+	gzFile gz;
+	ssize_t n;
+	int errnum;
+	int targetFD;
+	int result = 0;
+
+	targetFD = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0640);
+	if (targetFD == -1) {
+		perror(path);
+		return 1;
+	}
+
+	if (gzLevel == Z_DEFAULT_COMPRESSION) {
+		sprintf(mode, "wb");
+	}
+	else {
+		sprintf(mode, "wb%d", gzLevel);
+	}
+	gz = gzdopen(targetFD, mode);
+	if (gz == NULL) {
+		fprintf(stderr, "%s: cannot start compression\n", path);
+		close(targetFD);
+		return 1;
+	}
+	gzbuffer(gz, GZ_BUFFER);
+
+	while ((n = read(STDIN_FILENO, buffer, GZ_BUFFER)) != 0) {
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n == -1) {
+			perror("compression read()");
+			result = 1;
+			break;
+		}
+		if (gzwrite(gz, buffer, n) != n) {
+			fprintf(stderr, "%s: %s\n", path, gzerror(gz, &errnum));
+			result = 1;
+			break;
+		}
+	}
+
+	if (gzclose(gz) != Z_OK) { // writes the rest of the stream and the trailer
+		fprintf(stderr, "%s: error finishing compressed file\n", path);
+		result = 1;
+	}
+	free(buffer);
+	return result;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  runInflate
+* -------------
+*  Decompresses a gzip file to stdout. A file that is not compressed
+*  is copied as it is.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address of the file to
+*			read, for messages
+*
+*  sourceFD: an int that is the file descriptor of the file, opened by
+*			the shell so a missing file fails the command instead of
+*			giving it empty input
+*
+*  Returns 0 once the whole file has been written, returns 1 and prints
+*  a message with the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int runInflate(char* path, int sourceFD) {
+	char* buffer = malloc(GZ_BUFFER);
+	gzFile gz;
+	int n;
+	int errnum;
+	ssize_t written;
+	ssize_t w;
+	int result = 0;
+
+	gz = gzdopen(sourceFD, "rb");
+	if (gz == NULL) {
+		perror(path); // stdout is the pipe to the command
+		return 1;
+	}
+	gzbuffer(gz, GZ_BUFFER);
+
+	while ((n = gzread(gz, buffer, GZ_BUFFER)) > 0) {
+		for (written = 0; written < n; written += w) {
+			w = write(STDOUT_FILENO, buffer + written, n - written);
+			if (w == -1 && errno == EINTR) {
+				w = 0;
+			}
+			else if (w == -1) { // the command stopped reading, which is not an error
+				break;
+			}
+		}
+		if (written < n) {
+			break;
+		}
+	}
+	if (n == -1) {
+		fprintf(stderr, "%s: %s\n", path, gzerror(gz, &errnum));
+		result = 1;
+	}
+
+	gzclose(gz);
+	free(buffer);
+	return result;
+}
@@ -0,0 +1,62 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for the compressing redirections, ">z file.gz" and
+* "<z file.gz". They work like process substitutions whose helper process runs zlib instead of
+* a command, so the command reads and writes plain data through a pipe while the helper does the
+* compression. The shell only waits for the helper as long as it waits for the command.
+*/
+
+#ifndef GZIP_H
+#define GZIP_H
+
+
+#define GZ_BUFFER 131072 // bytes moved per read() and per zlib call
+
+
+extern int gzLevel; // compression level for ">z", 1 is fastest and 9 is smallest
+
+
+/*----------------------------------------------------------------------
+*
+*  runDeflate
+* -------------
+*  Compresses everything read from stdin into a gzip file until the
+*  write end of the pipe is closed.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address of the file to
+*			write, which is created or truncated
+*
+*  Returns 0 once all input has been written, returns 1 and prints a
+*  message with the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int runDeflate(char* path);
+
+
+/*----------------------------------------------------------------------
+*
+*  runInflate
+* -------------
+*  Decompresses a gzip file to stdout. A file that is not compressed
+*  is copied as it is.
+*
+* -------------
+*
+*  path: a string (char*) that contains the address of the file to
+*			read, for messages
+*
+*  sourceFD: an int that is the file descriptor of the file, opened by
+*			the shell so a missing file fails the command instead of
+*			giving it empty input
+*
+*  Returns 0 once the whole file has been written, returns 1 and prints
+*  a message with the error otherwise.
+*
+*---------------------------------------------------------------------*/
+int runInflate(char* path, int sourceFD);
+
+#endif
@@ -0,0 +1,297 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for publishing the shell's job table and counters in a shared
+* memory file under /dev/shm. The shell is the only writer and wraps every change in a sequence
+* lock, so monitors can read the table at any time without making the shell wait.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+
+#include "jobstat.h"
+
+
+struct statTable* statShared = NULL; // mapped table, NULL when not publishing
+pid_t statOwner = 0; // PID of the shell that created the table
+
+
+/*----------------------------------------------------------------------
+*
+*  epochMicros
+* -------------
+*  Gets the current time from the real time clock.
+*
+* -------------
+*
+*  Returns the current time in microseconds since the epoch.
+*
+*---------------------------------------------------------------------*/
+int64_t epochMicros() {
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  beginWrite
+* -------------
+*  Makes the sequence lock counter odd so readers know to retry.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void beginWrite() {
+	__atomic_store_n(&statShared->seq, statShared->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE); // counter must be visible before any of the changes
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  endWrite
+* -------------
+*  Makes the sequence lock counter even again once changes are done.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void endWrite() {
+	__atomic_store_n(&statShared->seq, statShared->seq + 1, __ATOMIC_RELEASE);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  statOpen
+* -------------
+*  Creates and maps the shared memory file for this shell. Until this
+*  is called, every other stat function does nothing. /dev/shm is
+*  writable by everyone, so the file is always created new and never
+*  through a symlink - a leftover file with the same name, from an
+*  earlier shell with this PID, is removed first. It is only readable
+*  by the user, since it lists the commands the shell runs.
+*
+* -------------
+*
+*  Returns 0 if successful, returns 1 and prints a message with the
+*  error otherwise.
+*
+*---------------------------------------------------------------------*/
+int statOpen() {
+	char path[256];
+	int fd;
+
+	statOwner = getpid();
+	sprintf(path, "%s/%s%d", STAT_DIR, STAT_PREFIX, statOwner);
+
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (fd == -1 && errno == EEXIST && unlink(path) == 0) { // fails, and so does statOpen(), if another user owns it
+		fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	}
+	if (fd == -1) {
+		perror("stat open()");
+		return 1;
+	}
+	if (ftruncate(fd, sizeof(struct statTable)) == -1) {
+		perror("stat ftruncate()");
+		close(fd);
+		unlink(path);
+		return 1;
+	}
+
+	statShared = mmap(NULL, sizeof(struct statTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (statShared == MAP_FAILED) {
+		perror("stat mmap()");
+		statShared = NULL;
+		unlink(path);
+		return 1;
+	}
+
+	// new file is all zeros, so every slot already starts out free
+	statShared->version = STAT_VERSION;
+	statShared->shellPid = statOwner;
+	statShared->started = epochMicros();
+	sprintf(statShared->lastStatus, "exit value 0");
+	__atomic_store_n(&statShared->magic, STAT_MAGIC, __ATOMIC_RELEASE); // readers skip the file until this is set
+
+	return 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  statClose
+* -------------
+*  Unmaps and removes the shared memory file. Only the shell itself
+*  removes it, so children that exit do not.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statClose() {
+	char path[256];
+
+	if (statShared == NULL || getpid() != statOwner) {
+		return;
+	}
+	munmap(statShared, sizeof(struct statTable));
+	statShared = NULL;
+
+	sprintf(path, "%s/%s%d", STAT_DIR, STAT_PREFIX, statOwner);
+	unlink(path);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  statCommand
+* -------------
+*  Counts one command line as run.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statCommand() {
+	if (statShared == NULL) {
+		return;
+	}
+	beginWrite();
+	statShared->commands++;
+	endWrite();
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  statSpawnFailed
+* -------------
+*  Counts one command that could not be started. Safe to call from a
+*  child whose exec failed.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statSpawnFailed() {
+	if (statShared == NULL) {
+		return;
+	}
+	__atomic_fetch_add(&statShared->spawnFailures, 1, __ATOMIC_RELAXED); // children write here too, so no sequence lock
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  statStart
+* -------------
+*  Adds a job to the table as running. Reuses a free slot, or the slot
+*  of the job that finished longest ago.
+*
+* -------------
+*
+*  pid: a pid_t that is the PID of the job
+*
+*  c: a pointer to the command struct being run
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statStart(pid_t pid, struct command* c) {
+	struct statJob* job = NULL;
+	size_t len = 0;
+	int i;
+
+	if (statShared == NULL) {
+		return;
+	}
+
+	for (i = 0; i < STAT_JOBS; i++) {
+		struct statJob* slot = &statShared->jobs[i];
+		if (slot->state == JOB_FREE) {
+			job = slot;
+			break;
+		}
+		if (slot->state == JOB_DONE && (job == NULL || slot->end < job->end)) {
+			job = slot;
+		}
+	}
+	if (job == NULL) { // every slot has a running job, leave this one out
+		return;
+	}
+
+	beginWrite();
+	job->pid = pid;
+	job->state = JOB_RUNNING;
+	job->background = c->background;
+	job->start = epochMicros();
+	job->end = 0;
+	job->status = 0;
+	job->command[0] = '\0';
+	for (i = 0; c->args[i] != NULL && len + 1 < STAT_CMD_LEN; i++) {
+		len += snprintf(job->command + len, STAT_CMD_LEN - len, "%s%s", (i > 0) ? " " : "", c->args[i]);
+	}
+	endWrite();
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  statFinish
+* -------------
+*  Marks a job in the table as finished.
+*
+* -------------
+*
+*  pid: a pid_t that is the PID of the job
+*
+*  childStatus: an int that is the wait status of the job
+*
+*  status: a string (char*) that is the new status of the last
+*			foreground command, or NULL for background jobs
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statFinish(pid_t pid, int childStatus, char* status) {
+	int i;
+
+	if (statShared == NULL) {
+		return;
+	}
+
+	beginWrite();
+	for (i = 0; i < STAT_JOBS; i++) {
+		struct statJob* job = &statShared->jobs[i];
+		if (job->state == JOB_RUNNING && job->pid == pid) {
+			job->state = JOB_DONE;
+			job->end = epochMicros();
+			job->status = childStatus;
+			break;
+		}
+	}
+	if (status != NULL) {
+		snprintf(statShared->lastStatus, sizeof(statShared->lastStatus), "%s", status);
+	}
+	endWrite();
+}
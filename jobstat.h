@@ -0,0 +1,214 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for publishing the shell's job table and counters in a
+* shared memory file under /dev/shm, so monitoring tools such as smalltop can see what every
+* shell of the same user is running without going through /proc. It also defines the layout of that file.
+*/
+
+#ifndef JOBSTAT_H
+#define JOBSTAT_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "command.h"
+
+
+#define STAT_DIR "/dev/shm" // where the tables are published
+#define STAT_PREFIX "smallsh." // file names are the prefix followed by the shell PID
+#define STAT_MAGIC 0x736d7368 // "smsh", marks a file as a job table
+#define STAT_VERSION 1
+#define STAT_JOBS 64 // max number of jobs listed at once
+#define STAT_CMD_LEN 128 // longer command lines are cut off
+
+#define JOB_FREE 0 // slot is unused
+#define JOB_RUNNING 1
+#define JOB_DONE 2
+
+
+/*----------------------------------------------------------------------
+*
+*  struct statJob
+* -------------
+*  Contains what a monitor needs to know about one job.
+*
+* -------------
+*
+*  pid: a pid_t that is the PID of the job
+*
+*  state: an int that is JOB_FREE, JOB_RUNNING or JOB_DONE
+*
+*  background: an int, 1 if the job runs in the background
+*
+*  start: an int64_t that is when the job started, in microseconds
+*			since the epoch
+*
+*  end: an int64_t that is when the job finished, or 0
+*
+*  status: an int that is the wait status of a finished job
+*
+*  command: a string (char[]) that contains the command line
+*
+*---------------------------------------------------------------------*/
+struct statJob {
+	pid_t pid;
+	int32_t state;
+	int32_t background;
+	int64_t start;
+	int64_t end;
+	int32_t status;
+	char command[STAT_CMD_LEN];
+};
+
+
+/*----------------------------------------------------------------------
+*
+*  struct statTable
+* -------------
+*  The contents of a shared memory file, written only by its shell.
+*
+*  Everything but spawnFailures is guarded by a sequence lock. The
+*  shell makes seq odd before changing anything and even again after,
+*  and a reader copies the table and retries if seq was odd or changed
+*  while it copied. Readers never block the shell.
+*
+* -------------
+*
+*  magic: a uint32_t that is always STAT_MAGIC
+*
+*  version: a uint32_t that is always STAT_VERSION
+*
+*  seq: a uint32_t that is the sequence lock counter
+*
+*  shellPid: a pid_t that is the PID of the shell
+*
+*  started: an int64_t that is when the shell started, in microseconds
+*			since the epoch
+*
+*  commands: an int64_t that is the number of command lines run
+*
+*  spawnFailures: an int64_t that is the number of commands that could
+*			not be started, updated atomically by the shell and its
+*			children
+*
+*  lastStatus: a string (char[]) that is the status of the last
+*			foreground command
+*
+*  jobs: an array of statJob structs that is the job table
+*
+*---------------------------------------------------------------------*/
+struct statTable {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t seq;
+	pid_t shellPid;
+	int64_t started;
+	int64_t commands;
+	int64_t spawnFailures;
+	char lastStatus[64];
+	struct statJob jobs[STAT_JOBS];
+};
+
+
+/*----------------------------------------------------------------------
+*
+*  statOpen
+* -------------
+*  Creates and maps the shared memory file for this shell. Until this
+*  is called, every other stat function does nothing.
+*
+* -------------
+*
+*  Returns 0 if successful, returns 1 and prints a message with the
+*  error otherwise.
+*
+*---------------------------------------------------------------------*/
+int statOpen();
+
+
+/*----------------------------------------------------------------------
+*
+*  statClose
+* -------------
+*  Unmaps and removes the shared memory file. Only the shell itself
+*  removes it, so children that exit do not.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statClose();
+
+
+/*----------------------------------------------------------------------
+*
+*  statCommand
+* -------------
+*  Counts one command line as run.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statCommand();
+
+
+/*----------------------------------------------------------------------
+*
+*  statSpawnFailed
+* -------------
+*  Counts one command that could not be started. Safe to call from a
+*  child whose exec failed.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statSpawnFailed();
+
+
+/*----------------------------------------------------------------------
+*
+*  statStart
+* -------------
+*  Adds a job to the table as running. Reuses a free slot, or the slot
+*  of the job that finished longest ago.
+*
+* -------------
+*
+*  pid: a pid_t that is the PID of the job
+*
+*  c: a pointer to the command struct being run
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statStart(pid_t pid, struct command* c);
+
+
+/*----------------------------------------------------------------------
+*
+*  statFinish
+* -------------
+*  Marks a job in the table as finished.
+*
+* -------------
+*
+*  pid: a pid_t that is the PID of the job
+*
+*  childStatus: an int that is the wait status of the job
+*
+*  status: a string (char*) that is the new status of the last
+*			foreground command, or NULL for background jobs
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void statFinish(pid_t pid, int childStatus, char* status);
+
+#endif
@@ -0,0 +1,395 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for the line editor used when the shell reads commands from a
+* terminal. The whole line is redrawn after every change, which keeps the editor simple and is
+* still far faster than anyone types. Signals are left on, so Ctrl-Z still toggles foreground-only
+* mode while a line is being typed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "command.h"
+#include "complete.h"
+#include "lineedit.h"
+
+
+#define DELETE_KEY 128 // stands for the Delete key, which sends an escape sequence instead of a byte
+
+
+char* history[HISTORY_LEN];
+int historyNum = 0;
+
+
+/*----------------------------------------------------------------------
+*
+*  redraw
+* -------------
+*  Prints the prompt and the line over the current terminal line and
+*  puts the cursor back where it belongs.
+*
+* -------------
+*
+*  prompt: a string (char*) that is printed before the line
+*
+*  line: a string (char*) that contains the line so far
+*
+*  len: an int that is the length of the line
+*
+*  pos: an int that is the position of the cursor in the line
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void redraw(char* prompt, char* line, int len, int pos) {
+	char out[MAX_LEN * 2];
+	int n;
+
+	n = snprintf(out, sizeof(out), "\r%s%.*s\x1b[K", prompt, len, line); // \x1b[K clears the rest of the line
+	if (pos < len) {
+		n += snprintf(out + n, sizeof(out) - n, "\x1b[%dD", len - pos); // move back to the cursor
+	}
+	write(STDOUT_FILENO, out, n);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  insertText
+* -------------
+*  Inserts text into the line at the cursor, as much as fits.
+*
+* -------------
+*
+*  line: a string (char*) of length size that contains the line
+*
+*  len: a pointer to an int that is the length of the line
+*
+*  pos: a pointer to an int that is the position of the cursor
+*
+*  size: an int that is the length of line
+*
+*  text: a string (char*) to insert
+*
+*  Returns nothing, but moves the cursor past the text.
+*
+*---------------------------------------------------------------------*/
+void insertText(char* line, int* len, int* pos, int size, char* text) {
+	int add = strlen(text);
+
+	if (*len + add > size - 1) {
+		add = size - 1 - *len;
+	}
+	memmove(line + *pos + add, line + *pos, *len - *pos + 1);
+	memcpy(line + *pos, text, add);
+	*len += add;
+	*pos += add;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  completeWord
+* -------------
+*  Completes the word before the cursor. The first word of the line is
+*  completed from the executables on PATH unless it has a slash, any
+*  other word is completed as a file name. When nothing more can be
+*  added, the matches are listed if asked for.
+*
+* -------------
+*
+*  prompt: a string (char*) that is printed before the line
+*
+*  line, len, pos, size: see insertText()
+*
+*  show: an int, 1 to list the matches if the word cannot be completed
+*			any further
+*
+*  Returns 1 if anything was added to the line, 0 otherwise.
+*
+*---------------------------------------------------------------------*/
+int completeWord(char* prompt, char* line, int* len, int* pos, int size, int show) {
+	char* matches[COMPLETE_MAX];
+	char word[MAX_LEN];
+	char common[MAX_LEN];
+	int start = *pos;
+	int command = 1;
+	int found;
+	int added = 0;
+	int i;
+
+	while (start > 0 && line[start - 1] != ' ') {
+		start--;
+	}
+	for (i = 0; i < start; i++) {
+		if (line[i] != ' ') {
+			command = 0;
+		}
+	}
+	snprintf(word, MAX_LEN, "%.*s", *pos - start, line + start);
+
+	if (command && strchr(word, '/') == NULL) {
+		found = completeCommand(word, common, MAX_LEN, matches, COMPLETE_MAX);
+	}
+	else {
+		found = completeFile(word, common, MAX_LEN, matches, COMPLETE_MAX);
+	}
+
+	if (strlen(common) > strlen(word)) {
+		insertText(line, len, pos, size, common + strlen(word));
+		added = 1;
+	}
+	if (found == 1 && common[strlen(common) - 1] != '/') { // finished the word
+		insertText(line, len, pos, size, " ");
+		added = 1;
+	}
+
+	if (found == 0) {
+		write(STDOUT_FILENO, "\a", 1);
+	}
+	else if (!added && show && found > 1) {
+		write(STDOUT_FILENO, "\r\n", 2);
+		for (i = 0; i < found; i++) {
+			write(STDOUT_FILENO, matches[i], strlen(matches[i]));
+			write(STDOUT_FILENO, (i == found - 1) ? "\r\n" : "  ", 2);
+		}
+	}
+
+	for (i = 0; i < found; i++) {
+		free(matches[i]);
+	}
+	redraw(prompt, line, *len, *pos);
+	return added;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  addHistory
+* -------------
+*  Adds a line to the end of the history, dropping the oldest one if
+*  the history is full. A line that repeats the last one is skipped.
+*
+* -------------
+*
+*  line: a string (char*) that contains the command line
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void addHistory(char* line) {
+	if (historyNum > 0 && strcmp(history[historyNum - 1], line) == 0) {
+		return;
+	}
+	if (historyNum == HISTORY_LEN) {
+		free(history[0]);
+		memmove(history, history + 1, (HISTORY_LEN - 1) * sizeof(char*));
+		historyNum--;
+	}
+	history[historyNum++] = strdup(line);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  showHistory
+* -------------
+*  Replaces the line with an entry of the history, or with the line
+*  that was being typed before going back through the history.
+*
+* -------------
+*
+*  line: a string (char*) of length size that contains the line
+*
+*  len, pos: pointers to ints that are set to the length of the new
+*			line, with the cursor at its end
+*
+*  size: an int that is the length of line
+*
+*  entry: an int that is the index in the history, or historyNum for
+*			the line being typed
+*
+*  draft: a string (char*) that contains the line being typed
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void showHistory(char* line, int* len, int* pos, int size, int entry, char* draft) {
+	snprintf(line, size, "%s", (entry == historyNum) ? draft : history[entry]);
+	*len = strlen(line);
+	*pos = *len;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  editLine
+* -------------
+*  Prints a prompt and reads a line from the terminal with editing.
+*  Lines that are not empty are added to the history.
+*
+* -------------
+*
+*  prompt: a string (char*) that is printed before the line
+*
+*  line: a string (char*) of length size that is filled with the line,
+*			without the newline
+*
+*  size: an int that is the length of line
+*
+*  Returns 0 if a line was read, returns -1 at the end of input.
+*
+*---------------------------------------------------------------------*/
+int editLine(char* prompt, char* line, int size) {
+	struct termios saved;
+	struct termios raw;
+	char draft[MAX_LEN] = "";
+	char seq[3];
+	unsigned char key;
+	int len = 0;
+	int pos = 0;
+	int entry = historyNum; // history entry shown, historyNum for the line being typed
+	int tabbed = 0; // 1 if the last key was a tab that added nothing
+	int result = 0;
+	ssize_t n;
+
+	tcgetattr(STDIN_FILENO, &saved);
+	raw = saved;
+	raw.c_lflag &= ~(ICANON | ECHO | IEXTEN); // keep ISIG so Ctrl-Z still sends SIGTSTP
+	raw.c_iflag &= ~(ICRNL | IXON);
+	raw.c_cc[VMIN] = 1;
+	raw.c_cc[VTIME] = 0;
+	tcsetattr(STDIN_FILENO, TCSADRAIN, &raw);
+
+	line[0] = '\0';
+	redraw(prompt, line, len, pos);
+
+	while (1) {
+		n = read(STDIN_FILENO, &key, 1);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			result = -1;
+			break;
+		}
+
+		if (key == '\t') {
+			tabbed = !completeWord(prompt, line, &len, &pos, size, tabbed);
+			continue;
+		}
+		tabbed = 0;
+
+		if (key == '\r' || key == '\n') {
+			break;
+		}
+		else if (key == 4 && len == 0) { // Ctrl-D
+			result = -1;
+			break;
+		}
+		else if (key == 27) { // escape sequence for the arrows and other special keys
+			if (read(STDIN_FILENO, &seq[0], 1) != 1 || read(STDIN_FILENO, &seq[1], 1) != 1) {
+				continue;
+			}
+			if (seq[0] == '[' && seq[1] >= '0' && seq[1] <= '9') { // ends with a ~
+				if (read(STDIN_FILENO, &seq[2], 1) != 1 || seq[2] != '~') {
+					continue;
+				}
+				switch (seq[1]) {
+				case '1': case '7': key = 1; break;
+				case '4': case '8': key = 5; break;
+				case '3': key = DELETE_KEY; break;
+				default: key = 0;
+				}
+			}
+			else {
+				switch (seq[1]) {
+				case 'A': key = 16; break;
+				case 'B': key = 14; break;
+				case 'C': key = 6; break;
+				case 'D': key = 2; break;
+				case 'H': key = 1; break;
+				case 'F': key = 5; break;
+				default: key = 0;
+				}
+			}
+		}
+
+		switch (key) {
+		case 1: // Ctrl-A, Home
+			pos = 0;
+			break;
+		case 5: // Ctrl-E, End
+			pos = len;
+			break;
+		case 2: // Ctrl-B, Left
+			if (pos > 0) {
+				pos--;
+			}
+			break;
+		case 6: // Ctrl-F, Right
+			if (pos < len) {
+				pos++;
+			}
+			break;
+		case 16: // Ctrl-P, Up
+			if (entry > 0) {
+				if (entry == historyNum) {
+					snprintf(draft, MAX_LEN, "%s", line);
+				}
+				showHistory(line, &len, &pos, size, --entry, draft);
+			}
+			break;
+		case 14: // Ctrl-N, Down
+			if (entry < historyNum) {
+				showHistory(line, &len, &pos, size, ++entry, draft);
+			}
+			break;
+		case 127: // Backspace
+		case 8:
+			if (pos > 0) {
+				memmove(line + pos - 1, line + pos, len - pos + 1);
+				pos--;
+				len--;
+			}
+			break;
+		case DELETE_KEY:
+		case 4: // Ctrl-D on a line that is not empty
+			if (pos < len) {
+				memmove(line + pos, line + pos + 1, len - pos);
+				len--;
+			}
+			break;
+		case 21: // Ctrl-U
+			memmove(line, line + pos, len - pos + 1);
+			len -= pos;
+			pos = 0;
+			break;
+		case 11: // Ctrl-K
+			line[pos] = '\0';
+			len = pos;
+			break;
+		default:
+			if (key >= 32 && key < 127) {
+				seq[0] = key;
+				seq[1] = '\0';
+				insertText(line, &len, &pos, size, seq);
+			}
+		}
+		redraw(prompt, line, len, pos);
+	}
+
+	write(STDOUT_FILENO, "\r\n", 2);
+	tcsetattr(STDIN_FILENO, TCSADRAIN, &saved);
+
+	if (result == 0 && len > 0) {
+		addHistory(line);
+	}
+	return result;
+}
@@ -0,0 +1,46 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for the line editor used when the shell reads commands from
+* a terminal. It puts the terminal in raw mode while a line is typed and supports moving the
+* cursor, going through earlier command lines, and tab completion of command and file names.
+*
+* Keys:
+*	Left, Right, Ctrl-B, Ctrl-F		move the cursor
+*	Home, End, Ctrl-A, Ctrl-E		move to the start or end of the line
+*	Up, Down, Ctrl-P, Ctrl-N		go through the history
+*	Backspace, Delete, Ctrl-U, Ctrl-K	delete a letter, or up to the start or end of the line
+*	Tab								complete, twice to list the matches
+*	Ctrl-D							end of input on an empty line
+*/
+
+#ifndef LINEEDIT_H
+#define LINEEDIT_H
+
+
+#define HISTORY_LEN 500 // most command lines kept in the history
+
+
+/*----------------------------------------------------------------------
+*
+*  editLine
+* -------------
+*  Prints a prompt and reads a line from the terminal with editing.
+*  Lines that are not empty are added to the history.
+*
+* -------------
+*
+*  prompt: a string (char*) that is printed before the line
+*
+*  line: a string (char*) of length size that is filled with the line,
+*			without the newline
+*
+*  size: an int that is the length of line
+*
+*  Returns 0 if a line was read, returns -1 at the end of input.
+*
+*---------------------------------------------------------------------*/
+int editLine(char* prompt, char* line, int size);
+
+#endif
@@ -3,14 +3,16 @@
 * CS344 - Assignment 3
 *
 * This is my submission for the third assignment for Operating Systems, an implementation of
-* a simple shell in C. It contains three built in commands: cd, status, and exit. To perform 
-* other commands, it forks a child and runs the commands with execvp. The shell also supports
-* blank lines and comments, expansion of $$ into the shell PID, input and output redirection,
-* and running processes in the background. It also handles SIGINT signals such that the shell
-* and background processes are not interupted, and SIGTSTP signals, which toggle on and off
-* foreground-only mode.
+* a simple shell in C. It contains the built in commands listed in builtins.def, such as cd,
+* status, exit, export and dag, and more can be loaded with enable. To perform other commands, it
+* forks a child and runs the commands with execvpe. The shell also supports blank lines and
+* comments, expansion of $$ into the shell PID, input and output redirection, and running
+* processes in the background. It also handles SIGINT signals such that the shell and background
+* processes are not interupted, and SIGTSTP signals, which toggle on and off foreground-only mode.
 */
 
+#define _GNU_SOURCE // for memfd_create()
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,9 +22,21 @@
 #include <sys/wait.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <sys/mman.h> // for memfd_create()
 #include <ctype.h> // for isspace()
 
+#include "builtin.h"
 #include "command.h"
+#include "coproc.h"
+#include "dag.h"
+#include "fastcopy.h"
+#include "fdcache.h"
+#include "gzip.h"
+#include "lineedit.h"
+#include "jobstat.h"
+#include "relay.h"
+#include "replay.h"
+#include "vars.h"
 
 
 volatile sig_atomic_t fgOnly = 0; // foreground only, 0 = no, 1 = yes
@@ -40,12 +54,17 @@ volatile sig_atomic_t fgOnly = 0; // foreground only, 0 = no, 1 = yes
 *  num: a pid_t that contains the PID of a process running in the
 *		background
 * 
+*  helper: an integer, where 0 means the process is a background
+*			command and 1 means it is a helper process for one, such
+*			as an output relay, that is reaped without a message
+* 
 *  next: a pointer to a pid struct that represents the next pid struct
 *			in the linked list
 *
 *---------------------------------------------------------------------*/
 struct pid {
 	pid_t num;
+	int helper;
 	struct pid* next;
 };
 
@@ -78,13 +97,99 @@ int inputRedirect(char* input) {
 	if (sourceFD == -1) {
 		printf("cannot open %s for input\n", input);
 		fflush(stdout);
-		exit(1);
+		_exit(1);
 	}
 
 	tryDup2 = dup2(sourceFD, 0);
 	if (tryDup2 == -1) {
 		perror("input dup2()");
-		exit(1);
+		_exit(1);
+	}
+
+	return 0;
+
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  hereFD
+* -------------
+*  Puts the body of a here-document or here-string in an anonymous
+*  in-memory file that is sealed against changes, so it never touches
+*  the disk and no process has to stay around to feed it to a command.
+*
+* -------------
+*
+*  body: a string (char*) that contains the text to be read by the
+*			command
+*
+*  Returns a file descriptor for the file, positioned at the start, or
+*  -1 and prints a message with the error if it cannot be made.
+*
+*---------------------------------------------------------------------*/
+int hereFD(char* body) {
+	int sourceFD;
+	size_t len = strlen(body);
+	size_t written = 0;
+	ssize_t n;
+
+
+	sourceFD = memfd_create("smallsh-heredoc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (sourceFD == -1) {
+		perror("here-document memfd_create()");
+		return -1;
+	}
+
+	while (written < len) {
+		n = write(sourceFD, body + written, len - written);
+		if (n == -1) {
+			perror("here-document write()");
+			close(sourceFD);
+			return -1;
+		}
+		written += n;
+	}
+
+	// make the contents read-only, then rewind for the command to read from the start
+	fcntl(sourceFD, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+	lseek(sourceFD, 0, SEEK_SET);
+
+	return sourceFD;
+
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  hereRedirect
+* -------------
+*  Redirects stdin to the body of a here-document or here-string,
+*  using hereFD().
+*
+* -------------
+*
+*  body: a string (char*) that contains the text to be read by the
+*			command
+*
+*  Returns 1 if the input cannot be redirected and prints a message
+*  with the error, returns 0 if successful.
+*
+*---------------------------------------------------------------------*/
+int hereRedirect(char* body) {
+	int sourceFD;
+	int tryDup2;
+
+
+	sourceFD = hereFD(body);
+	if (sourceFD == -1) {
+		_exit(1);
+	}
+
+	tryDup2 = dup2(sourceFD, 0);
+	if (tryDup2 == -1) {
+		perror("input dup2()");
+		_exit(1);
 	}
 
 	return 0;
@@ -97,7 +202,7 @@ int inputRedirect(char* input) {
 *  outputRedirect
 * -------------
 *  Redirects stdout to the specified file. Creates the file if it does
-*  not exist, truncates it if it does. 
+*  not exist, truncates or appends to it if it does. 
 *
 *  Fulfills requirement 6 of the assignment, in conjunction with 
 *  inputRedirect(), by redirecting output from standard output to a
@@ -107,26 +212,29 @@ int inputRedirect(char* input) {
 *
 *  input: a string (char*) that contains the address of the file to
 *			be written to
+* 
+*  append: an int, where 0 means the file is truncated and 1 means the
+*			output is added to the end of the file
 *
 *  Returns 1 if the output cannot be redirected and prints a message
 *  with the error, returns 0 if successful.
 *
 *---------------------------------------------------------------------*/
-int outputRedirect(char* output) {
+int outputRedirect(char* output, int append) {
 	int targetFD;
 	int tryDup2;
 
 
-	targetFD = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0640);
+	targetFD = open(output, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0640);
 	if (targetFD == -1) {
 		perror("output open()");
-		exit(1);
+		_exit(1);
 	}
 
 	tryDup2 = dup2(targetFD, 1);
 	if (tryDup2 == -1) {
 		perror("output dup2()");
-		exit(1);
+		_exit(1);
 	}
 
 	return 0;
@@ -134,12 +242,326 @@ int outputRedirect(char* output) {
 }
 
 
+/*----------------------------------------------------------------------
+*
+*  errorRedirect
+* -------------
+*  Redirects stderr to the specified file. Creates the file if it does
+*  not exist, truncates or appends to it if it does.
+*
+* -------------
+*
+*  errOutput: a string (char*) that contains the address of the file
+*			to be written to
+* 
+*  append: an int, where 0 means the file is truncated and 1 means the
+*			errors are added to the end of the file
+*
+*  Returns 1 if the errors cannot be redirected and prints a message
+*  with the error, returns 0 if successful.
+*
+*---------------------------------------------------------------------*/
+int errorRedirect(char* errOutput, int append) {
+	int targetFD;
+	int tryDup2;
+
+
+	targetFD = open(errOutput, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0640);
+	if (targetFD == -1) {
+		perror("error output open()");
+		_exit(1);
+	}
+
+	tryDup2 = dup2(targetFD, 2);
+	if (tryDup2 == -1) {
+		perror("error output dup2()");
+		_exit(1);
+	}
+
+	return 0;
+
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  cacheTargets
+* -------------
+*  Looks up the output and error files of a command in the redirection
+*  cache, in the parent, so the child only has to dup2() them.
+*
+* -------------
+*
+*  c: a command struct that is about to be executed
+* 
+*  relayFD: an int that is the write end of the relay pipe, or -1 if
+*			the command has no relay
+* 
+*  cached: an array of two ints that is filled with the cached file
+*			descriptors for stdout and stderr, or -1 for each one the
+*			child has to open itself
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void cacheTargets(struct command* c, int relayFD, int* cached) {
+	cached[0] = -1;
+	cached[1] = -1;
+	if (relayFD == -1 && c->outNum == 1 && c->substNum == 0) {
+		cached[0] = cacheTarget(c->output[0], c->append[0]);
+	}
+	if (c->errOutput != NULL) {
+		cached[1] = cacheTarget(c->errOutput, c->errAppend);
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  redirectOutputs
+* -------------
+*  Redirects stdout of a child to wherever the command sends its
+*  output, either the pipe of an output relay or a single file, and
+*  stderr to wherever the command sends its errors.
+*
+* -------------
+*
+*  c: a command struct that is about to be executed
+* 
+*  relayFD: an int that is the write end of the relay pipe, or -1 if
+*			the command has no relay
+* 
+*  cached: an array of two ints that are file descriptors from the
+*			redirection cache for stdout and stderr, or -1 if the
+*			file has to be opened
+*
+*  Returns 1 if the output was redirected, returns 0 if the command
+*  has no output files.
+*
+*---------------------------------------------------------------------*/
+int redirectOutputs(struct command* c, int relayFD, int* cached) {
+	int redirected = 1;
+
+	if (cached[1] != -1) {
+		if (dup2(cached[1], 2) == -1) {
+			perror("error output dup2()");
+			_exit(1);
+		}
+	}
+	else if (c->errOutput != NULL) {
+		errorRedirect(c->errOutput, c->errAppend);
+	}
+
+	if (relayFD != -1) {
+		if (dup2(relayFD, 1) == -1) {
+			perror("output dup2()");
+			_exit(1);
+		}
+		close(relayFD);
+	}
+	else if (cached[0] != -1) {
+		if (dup2(cached[0], 1) == -1) {
+			perror("output dup2()");
+			_exit(1);
+		}
+	}
+	else if (c->outNum == 1) {
+		outputRedirect(c->output[0], c->append[0]);
+	}
+	else {
+		redirected = 0;
+	}
+
+	if (redirected && c->errToOut) {
+		dup2(1, 2);
+	}
+	return redirected;
+}
+
+
+int isBlank(char* str); // to prevent implicit declaration
+
+
+/*----------------------------------------------------------------------
+*
+*  execCommand
+* -------------
+*  Replaces the child process with a command, passing it the exported
+*  variables plus the NAME=value words that came before it. Only the
+*  child sets those, so the shell's cached environment is untouched
+*  unless the command has some. A line with only redirections runs
+*  cat, which copies its input to its output.
+*
+* -------------
+*
+*  c: a command struct that is to be executed
+*
+*  Returns only if the exec failed.
+*
+*---------------------------------------------------------------------*/
+void execCommand(struct command* c) {
+	int i;
+
+	for (i = 0; i < c->assignNum; i++) {
+		varAssign(c->assign[i], 1);
+	}
+	if (c->name[0] == '\0') {
+		free(c->name);
+		c->name = strdup("cat");
+		c->args[0] = strdup("cat");
+		c->args[1] = NULL;
+	}
+	execvpe(c->name, c->args, varEnviron());
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  startSubstitutions
+* -------------
+*  Starts a helper process for each process substitution of a command
+*  and replaces the matching arguments with /dev/fd paths to the pipes
+*  that connect the helpers to the command. The helpers of >z and <z
+*  redirections compress or decompress their file instead of running
+*  a command. A <z file is opened here, and if that fails no helper is
+*  started and the command is left to fail to open it like a plain <
+*  redirection.
+*
+* -------------
+*
+*  c: a command struct that is about to be executed
+* 
+*  fg: an int, 1 if the command runs in the foreground so the helpers
+*		can be interupted by SIGINT, 0 otherwise
+* 
+*  helpers: an array of pid_ts that the PIDs of the helpers are added
+*			to, starting at index helperNum
+* 
+*  subFDs: an array of ints that is filled with the command's end of
+*			each pipe, which must be closed once the command is forked
+*
+*  Returns the number of helpers started.
+*
+*---------------------------------------------------------------------*/
+int startSubstitutions(struct command* c, int fg, pid_t* helpers, int* subFDs) {
+	int n = 0; // helpers started, which can be fewer than substitutions
+	int i;
+	int j;
+
+	for (i = 0; i < c->substNum; i++) {
+		int subPipe[2];
+		int out = c->substOut[i]; // 1 if the helper reads what the command writes
+		int zipFD = -1;
+		char* line;
+		char** replaced;
+		struct command* inner;
+
+		// swap the placeholder for the path to the pipe, or back to the file if it cannot be read
+		if (c->substArg[i] == -1) {
+			replaced = &c->input;
+		}
+		else if (c->substArg[i] >= ARG_NUM) {
+			replaced = &c->output[c->substArg[i] - ARG_NUM];
+		}
+		else {
+			replaced = &c->args[c->substArg[i]];
+		}
+		if (c->substZip[i] && !out) {
+			zipFD = open(c->subst[i], O_RDONLY | O_CLOEXEC);
+			if (zipFD == -1) {
+				free(*replaced);
+				*replaced = strdup(c->subst[i]);
+				continue;
+			}
+		}
+
+		if (pipe2(subPipe, O_CLOEXEC) == -1) {
+			perror("substitution pipe()");
+			exit(1);
+		}
+
+		fflush(stdout);
+		helpers[n] = fork();
+		switch (helpers[n]) {
+		case -1:
+			perror("fork()\n");
+			exit(1);
+			break;
+
+		case 0: // helper
+			if (fg && !c->substZip[i]) { // compression keeps going to finish the file if the command is interupted
+				signal(SIGINT, SIG_DFL);
+			}
+			if (dup2(subPipe[out ? 0 : 1], out ? 0 : 1) == -1) {
+				perror("substitution dup2()");
+				_exit(1);
+			}
+			if (c->substZip[i]) {
+				// no exec to close the pipes, so close them here or the helper never sees the end of its input
+				close(subPipe[0]);
+				close(subPipe[1]);
+				for (j = 0; j < n; j++) {
+					close(subFDs[j]);
+				}
+				coprocCloseFds();
+				signal(SIGTSTP, SIG_IGN);
+				signal(SIGPIPE, SIG_IGN); // a command that stops reading gives EPIPE, which ends the helper quietly
+				_exit(out ? runDeflate(c->subst[i]) : runInflate(c->subst[i], zipFD)); // exit() would rewind the shell's stdin
+			}
+
+			line = calloc(MAX_LEN, sizeof(char));
+			strcpy(line, c->subst[i]);
+			if (isBlank(line)) {
+				_exit(0);
+			}
+			inner = parseCommand(line);
+			if (inner->input != NULL) {
+				inputRedirect(inner->input);
+			}
+			else if (!out && !fg) {
+				inputRedirect("/dev/null");
+			}
+			if (inner->outNum > 0) {
+				outputRedirect(inner->output[0], inner->append[0]);
+				if (inner->errToOut) {
+					dup2(1, 2);
+				}
+			}
+			if (inner->errOutput != NULL) {
+				errorRedirect(inner->errOutput, inner->errAppend);
+			}
+			execCommand(inner);
+
+			perror(inner->name);
+			_exit(1);
+			break;
+
+		default: // parent
+			close(subPipe[out ? 0 : 1]);
+			if (zipFD != -1) {
+				close(zipFD);
+			}
+			subFDs[n] = subPipe[out ? 1 : 0];
+
+			free(*replaced);
+			*replaced = calloc(32, sizeof(char));
+			sprintf(*replaced, "/dev/fd/%d", subFDs[n]);
+			n++;
+		}
+	}
+
+	return n;
+}
+
+
 /*----------------------------------------------------------------------
 *
 *  foreground
 * -------------
 *  Runs the given command in the foreground using a child process and
-*  execvp.
+*  execvp. Commands with several output files also get a relay process
+*  and process substitutions get a helper process each, which are all
+*  waited for along with the command.
 * 
 *  Fulfills requirement 5 of the assignment by using fork(), an exec()
 *  function, and waitpid() to create a child to run commands that are
@@ -165,9 +587,31 @@ int outputRedirect(char* output) {
 *
 *---------------------------------------------------------------------*/
 char* foreground(struct command* c, char* status) {
-	pid_t newPid = fork();
+	pid_t newPid;
+	pid_t helpers[SUB_NUM + 1]; // process substitutions and output relay
+	int helperNum = 0;
+	int subFDs[SUB_NUM];
+	int relayFD = -1;
+	int cached[2]; // file descriptors from the redirection cache
 	int childStatus;
+	int i;
+
+	helperNum = startSubstitutions(c, 1, helpers, subFDs);
+	if (c->outNum > 1) {
+		helpers[SUB_NUM] = startRelay(c, &relayFD);
+		if (helpers[SUB_NUM] == -1) {
+			for (i = 0; i < helperNum; i++) {
+				close(subFDs[i]);
+				waitpid(helpers[i], NULL, 0);
+			}
+			sprintf(status, "exit value 1");
+			statSpawnFailed();
+			return status;
+		}
+	}
+	cacheTargets(c, relayFD, cached);
 
+	newPid = fork();
 	switch (newPid) {
 	case -1:
 		perror("fork()\n");
@@ -179,23 +623,43 @@ char* foreground(struct command* c, char* status) {
 		if (c->input != NULL) {
 			inputRedirect(c->input);
 		}
-		if (c->output != NULL) {
-			outputRedirect(c->output);
+		else if (c->hereBody != NULL) {
+			hereRedirect(c->hereBody);
 		}
-		execvp(c->name, c->args);
+		redirectOutputs(c, relayFD, cached);
+		for (i = 0; i < helperNum; i++) {
+			fcntl(subFDs[i], F_SETFD, 0); // keep substitution pipes open across exec
+		}
+		execCommand(c);
 
 		perror(c->name);
-		exit(1);
+		statSpawnFailed();
+		_exit(1);
 		break;
 
 	default: // parent
+		if (relayFD != -1) {
+			close(relayFD); // relay sees the end of the output once the child exits
+		}
+		for (i = 0; i < helperNum; i++) {
+			close(subFDs[i]); // same for helpers reading from >(cmd)
+		}
+		statStart(newPid, c);
 		newPid = waitpid(newPid, &childStatus, 0);
+		for (i = 0; i < helperNum; i++) {
+			waitpid(helpers[i], NULL, 0);
+		}
+		if (relayFD != -1) {
+			waitpid(helpers[SUB_NUM], NULL, 0);
+		}
 		if (WIFEXITED(childStatus)) {
 			sprintf(status, "exit value %d", WEXITSTATUS(childStatus));
+			statFinish(newPid, childStatus, status);
 			return status;
 		}
 		else {
 			sprintf(status, "terminated by signal %d", WTERMSIG(childStatus));
+			statFinish(newPid, childStatus, status);
 			printf("%s\n", status); // print the required termination message
 			fflush(stdout);
 			return status;
@@ -208,10 +672,10 @@ char* foreground(struct command* c, char* status) {
 
 /*----------------------------------------------------------------------
 *
-*  background
+*  spawnCommand
 * -------------
-*  Runs the given command in the background using a child process and
-*  execvp. 
+*  Runs the given command using a child process and execvp, without
+*  waiting for it or announcing it.
 *
 *  Fulfills requirement 5 of the assignment, in conjunction with
 *  checkBackground(), by using fork() and an exec() function to
@@ -224,13 +688,45 @@ char* foreground(struct command* c, char* status) {
 * -------------
 *
 *  c: a command struct that is to be executed
+* 
+*  helpers: an array of pid_ts that is filled with the PIDs of helper
+*			processes, such as an output relay and process
+*			substitutions, which must be reaped along with the command
+* 
+*  helperNum: a pointer to an int that is set to the number of helpers
+*
+*  detached: an int, 1 if input and output that are not redirected go
+*			to /dev/null like a background command, 0 if they are the
+*			shell's own
 *
-*  Returns the PID of the child process running in the background.
+*  Returns the PID of the child process, or -1 if the output files
+*  could not be opened.
 *
 *---------------------------------------------------------------------*/
-pid_t background(struct command* c) {
-	pid_t newPid = fork();
+pid_t spawnCommand(struct command* c, pid_t* helpers, int* helperNum, int detached) {
+	pid_t newPid;
+	int subFDs[SUB_NUM];
+	int subNum;
+	int relayFD = -1;
+	int cached[2] = { -1, -1 }; // the redirection cache is only for foreground commands, see cacheTarget()
+	int i;
+
+	subNum = startSubstitutions(c, 0, helpers, subFDs);
+	*helperNum = subNum;
+	if (c->outNum > 1) {
+		helpers[SUB_NUM] = startRelay(c, &relayFD);
+		if (helpers[SUB_NUM] == -1) {
+			for (i = 0; i < subNum; i++) {
+				close(subFDs[i]); // helpers are still reaped by the caller
+			}
+			return -1;
+		}
+	}
+	if (relayFD != -1) {
+		helpers[(*helperNum)++] = helpers[SUB_NUM];
+	}
 
+	newPid = fork();
 	switch (newPid) {
 	case -1:
 		perror("fork()\n");
@@ -241,25 +737,33 @@ pid_t background(struct command* c) {
 		if (c->input != NULL) {
 			inputRedirect(c->input);
 		}
-		else {
+		else if (c->hereBody != NULL) {
+			hereRedirect(c->hereBody);
+		}
+		else if (detached) {
 			inputRedirect("/dev/null");
 		}
-		if (c->output != NULL) {
-			outputRedirect(c->output);
+		if (!redirectOutputs(c, relayFD, cached) && detached) {
+			outputRedirect("/dev/null", 0);
 		}
-		else {
-			inputRedirect("/dev/null");
+		for (i = 0; i < subNum; i++) {
+			fcntl(subFDs[i], F_SETFD, 0); // keep substitution pipes open across exec
 		}
 
-		execvp(c->name, c->args);
+		execCommand(c);
 
 		perror(c->name);
-		exit(1);
+		statSpawnFailed();
+		_exit(1);
 		break;
 
 	default: // parent
-		printf("background pid is %d\n", newPid);
-		fflush(stdout);
+		if (relayFD != -1) {
+			close(relayFD);
+		}
+		for (i = 0; i < subNum; i++) {
+			close(subFDs[i]);
+		}
 		return newPid;
 
 	}
@@ -267,6 +771,92 @@ pid_t background(struct command* c) {
 }
 
 
+/*----------------------------------------------------------------------
+*
+*  spawnBackground
+* -------------
+*  Runs the given command in the background using a child process and
+*  execvp, without announcing it. Also used to start the commands of a
+*  replay.
+*
+* -------------
+*
+*  c, helpers, helperNum: see spawnCommand()
+*
+*  Returns the PID of the child process running in the background, or
+*  -1 if the output files could not be opened.
+*
+*---------------------------------------------------------------------*/
+pid_t spawnBackground(struct command* c, pid_t* helpers, int* helperNum) {
+	return spawnCommand(c, helpers, helperNum, 1);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  spawnAttached
+* -------------
+*  Runs the given command without waiting for it, but with the shell's
+*  stdin, stdout and stderr like a foreground command. Used to start
+*  the commands of a dag, whose output should be seen.
+*
+* -------------
+*
+*  c, helpers, helperNum: see spawnCommand()
+*
+*  Returns the PID of the child process, or -1 if the output files
+*  could not be opened.
+*
+*---------------------------------------------------------------------*/
+pid_t spawnAttached(struct command* c, pid_t* helpers, int* helperNum) {
+	return spawnCommand(c, helpers, helperNum, 0);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  background
+* -------------
+*  Runs the given command in the background using a child process and
+*  execvp. 
+*
+*  Fulfills requirement 5 of the assignment, in conjunction with
+*  checkBackground(), by using fork() and an exec() function to
+*  create a child to run commands that are not built in.
+* 
+*  Fulfills requirement 7 of the assignment, in conjunction with
+*  foreground() and checkBackground(), by running commands as 
+*  background processes.
+*
+* -------------
+*
+*  c: a command struct that is to be executed
+* 
+*  helpers: an array of pid_ts that is filled with the PIDs of helper
+*			processes, such as an output relay and process
+*			substitutions, which must be reaped along with the command
+* 
+*  helperNum: a pointer to an int that is set to the number of helpers
+*
+*  Returns the PID of the child process running in the background, or
+*  -1 if the output files could not be opened.
+*
+*---------------------------------------------------------------------*/
+pid_t background(struct command* c, pid_t* helpers, int* helperNum) {
+	pid_t newPid = spawnBackground(c, helpers, helperNum);
+
+	if (newPid != -1) {
+		statStart(newPid, c);
+		printf("background pid is %d\n", newPid);
+		fflush(stdout);
+	}
+	else {
+		statSpawnFailed();
+	}
+	return newPid;
+}
+
+
 /*----------------------------------------------------------------------
 *
 *  checkBackground
@@ -288,8 +878,8 @@ pid_t background(struct command* c) {
 *			structs
 *
 *  Prints exit status messages for completed background processes. 
-*  Returns the head of the linked list with completed processes
-*  removed.
+*  Helper processes are removed without a message. Returns the head of
+*  the linked list with completed processes removed.
 *
 *---------------------------------------------------------------------*/
 struct pid* checkBackground(struct pid* head) {
@@ -300,7 +890,12 @@ struct pid* checkBackground(struct pid* head) {
 
 	while (curr != NULL) {
 		childPid = waitpid(curr->num, &childStatus, WNOHANG); // don't wait, just check
-		if (childPid != 0) {
+		if (childPid != 0 && curr->helper) {
+			// helpers finish on their own once their command does
+		}
+		else if (childPid != 0) {
+			coprocReaped(childPid);
+			statFinish(childPid, childStatus, NULL);
 			printf("background pid %d is done: ", childPid);
 			fflush(stdout);
 			if (WIFEXITED(childStatus)) {
@@ -311,9 +906,13 @@ struct pid* checkBackground(struct pid* head) {
 			}
 			fflush(stdout);
 
+		}
+
+		if (childPid != 0) {
 			// remove completed pid structs
 			if (prev == NULL) {
 				head = head->next;
+				free(curr);
 				curr = head;
 			}
 			else {
@@ -333,6 +932,44 @@ struct pid* checkBackground(struct pid* head) {
 }
 
 
+/*----------------------------------------------------------------------
+*
+*  addPid
+* -------------
+*  Adds a PID to the end of the linked list of background processes.
+*
+* -------------
+*
+*  head: a pid struct that acts as the head of the linked list of pid
+*			structs, or NULL if the list is empty
+* 
+*  num: a pid_t that contains the PID of the new background process
+* 
+*  helper: an int, 1 if the process is a helper that should be reaped
+*			without a message, 0 otherwise
+*
+*  Returns the head of the linked list with the new PID added.
+*
+*---------------------------------------------------------------------*/
+struct pid* addPid(struct pid* head, pid_t num, int helper) {
+	struct pid* newPid = malloc(sizeof(struct pid));
+	struct pid* curr = head;
+
+	newPid->num = num;
+	newPid->helper = helper;
+	newPid->next = NULL;
+
+	if (head == NULL) {
+		return newPid;
+	}
+	while (curr->next != NULL) {
+		curr = curr->next;
+	}
+	curr->next = newPid;
+	return head;
+}
+
+
 void SIGTSTP_off(int signum); // to prevent implicit declaration
 
 
@@ -427,37 +1064,108 @@ int isBlank(char* str) {
 
 /*----------------------------------------------------------------------
 *
-*  buildInCD
+*  runBuiltin
 * -------------
-*  Code for the built in change directory command for the shell.
+*  Runs a built in command inside the shell. The command's redirections
+*  and process substitutions are set up in the shell and handed to the
+*  command as file descriptors, so nothing is forked except helpers.
 *
 *  Fulfills requirement 4 of the assignment, in conjunction with
-*  getCommand(), by providing a built in cd command for the shell.
+*  getCommand() and the commands in builtin.c, by running built-in
+*  commands without creating a child.
 *
 * -------------
 *
-*  cd: a command struct that can contain an address as the second
-*		argument
+*  b: a pointer to the builtin struct of the command
+* 
+*  c: a command struct that is to be executed
+* 
+*  status: a string (char*) that contains the status of the last
+*			command run in the foreground, which is overwritten if
+*			the command sets the status
 *
-*  Changes directory to the specified directory or the home directory
-*  if one is not given. Returns the exit signal of chdir - currently
-*  unused.
+*  Returns 1 if the shell should exit, 0 otherwise.
 *
 *---------------------------------------------------------------------*/
-int builtInCD(struct command* cd) {
-	char* newDir;
-	int exitSig;
+int runBuiltin(struct builtin* b, struct command* c, char* status) {
+	struct builtinIO io;
+	pid_t helpers[SUB_NUM + 1];
+	int helperNum;
+	int subFDs[SUB_NUM];
+	int relayFD = -1;
+	int argc = 0;
+	int exitValue = 1;
+	int i;
+
+	io.in = STDIN_FILENO;
+	io.out = STDOUT_FILENO;
+	io.err = STDERR_FILENO;
+	io.status = status;
+	io.quit = 0;
+
+	helperNum = startSubstitutions(c, 1, helpers, subFDs);
+
+	if (c->input != NULL) {
+		io.in = open(c->input, O_RDONLY | O_CLOEXEC);
+		if (io.in == -1) {
+			printf("cannot open %s for input\n", c->input);
+			fflush(stdout);
+		}
+	}
+	else if (c->hereBody != NULL) {
+		io.in = hereFD(c->hereBody);
+	}
 
-	if (cd->args[1] == NULL) {
-		newDir = getenv("HOME");
+	if (io.in != -1 && c->outNum > 1) {
+		helpers[SUB_NUM] = startRelay(c, &relayFD);
+		io.out = relayFD;
 	}
-	else {
-		newDir = cd->args[1];
+	else if (io.in != -1 && c->outNum == 1) {
+		io.out = open(c->output[0], O_WRONLY | O_CREAT | O_CLOEXEC | (c->append[0] ? O_APPEND : O_TRUNC), 0640);
+		if (io.out == -1) {
+			perror("output open()");
+		}
 	}
 
-	exitSig = chdir(newDir);
+	if (io.in != -1 && io.out != -1 && c->errOutput != NULL) {
+		io.err = open(c->errOutput, O_WRONLY | O_CREAT | O_CLOEXEC | (c->errAppend ? O_APPEND : O_TRUNC), 0640);
+		if (io.err == -1) {
+			perror("error output open()");
+		}
+	}
+	else if (c->errToOut) {
+		io.err = io.out;
+	}
 
-	return exitSig;
+	if (io.in != -1 && io.out != -1 && io.err != -1) {
+		while (c->args[argc] != NULL) {
+			argc++;
+		}
+		fflush(stdout); // keep the order of anything the shell printed before the command writes
+		exitValue = b->func(argc, c->args, &io);
+	}
+
+	if (io.in != -1 && io.in != STDIN_FILENO) {
+		close(io.in);
+	}
+	if (io.err != -1 && io.err != STDERR_FILENO && io.err != io.out) {
+		close(io.err);
+	}
+	if (io.out != -1 && io.out != STDOUT_FILENO) {
+		close(io.out); // also ends the relay's input
+	}
+	for (i = 0; i < helperNum; i++) {
+		close(subFDs[i]);
+		waitpid(helpers[i], NULL, 0);
+	}
+	if (relayFD != -1) {
+		waitpid(helpers[SUB_NUM], NULL, 0);
+	}
+
+	if (b->setsStatus) {
+		sprintf(status, "exit value %d", exitValue);
+	}
+	return io.quit;
 }
 
 
@@ -469,8 +1177,8 @@ int builtInCD(struct command* cd) {
 *  is recieved.
 * 
 *  Fulfills requirement 4 of the assignment, in conjunction with
-*  builtInCD(), by implementing actions for built-in status and exit 
-*  commands.
+*  runBuiltin(), by running built-in commands such as cd, status and
+*  exit inside the shell.
 * 
 *  Fulfills requirement 8 of the assignment by ignoring SIGINT signals, 
 *  which is inherited by background processes as well, and by setting
@@ -479,16 +1187,30 @@ int builtInCD(struct command* cd) {
 *
 * -------------
 * 
-*  Returns 0 when the exit command is given.
+*  input: a FILE* that command lines are read from, either stdin or a
+*			script, which is run without prompts
+* 
+*  record: a FILE* that each command line is logged to along with its
+*			outcome, or NULL if the shell is not recording
+* 
+*  Returns 0 when the exit command is given or the input runs out.
 *
 *---------------------------------------------------------------------*/
-int getCommand() {
+int getCommand(FILE* input, FILE* record) {
 	char* status = malloc(MAX_LEN);
 	struct command* c;
+	char line[MAX_LEN]; // copy of the command line for the record, parsing modifies the original
+	char* outcome;
+	int hereDoc; // here-strings are already part of the line, only here-documents need their body recorded
+	struct builtin* b;
+	int quit = 0;
+	pid_t coprocJob;
+	int editing = (input == stdin && isatty(STDIN_FILENO)); // use the line editor for a terminal
+	long recordStart = nowMicros();
+	long started;
 
 	// linked list of background process PIDs
 	struct pid* head = NULL;
-	struct pid* tail = NULL;
 
 	sprintf(status, "exit value 0"); // default status for before any foreground processes are run
 
@@ -502,46 +1224,93 @@ int getCommand() {
 
 		char commandLine[MAX_LEN];
 
-		printf(": "); // prompt for command line
-		fflush(stdout);
-
-
-		fgets(commandLine, MAX_LEN, stdin); // get command from user input
+		if (editing) { // someone is typing, so let them edit the line
+			if (editLine(": ", commandLine, MAX_LEN) == -1) {
+				free(status);
+				return 0;
+			}
+		}
+		else {
+			if (input == stdin) {
+				printf(": "); // prompt for command line
+				fflush(stdout);
+			}
+			if (fgets(commandLine, MAX_LEN, input) == NULL) { // get command from user input, end of input acts like exit
+				free(status);
+				return 0;
+			}
+		}
 		if ((strlen(commandLine) > 0) && (commandLine[strlen(commandLine) - 1] == '\n')) {
 			commandLine[strlen(commandLine) - 1] = '\0'; // removes newline inserted by fgets()
 		}
 
 		if (!isBlank(commandLine)) {
+			statCommand();
+			strcpy(line, commandLine);
+			started = nowMicros();
+			outcome = "builtin";
+
 			c = parseCommand(commandLine);
-			if (strcmp(c->name, "exit") == 0) { // built in exit command
-				free(status);
-				return 0;
+			hereDoc = (c->hereDelim != NULL);
+			if (hereDoc) { // body of a here-document follows the command line
+				readHereDoc(c, input);
 			}
-			else if (strcmp(c->name, "cd") == 0) { // built in cd command
-				builtInCD(c);
+			for (int i = 0; c->name[0] == '\0' && i < c->assignNum; i++) {
+				varAssign(c->assign[i], 0); // no command, so they set shell variables
 			}
-			else if (strcmp(c->name, "status") == 0) { // built in status command
-				printf("%s\n", status);
-				fflush(stdout);
+			if (c->name[0] != '\0' && c->assignNum > 0) {
+				varPush(c->assign, c->assignNum); // built in commands and copies done by the shell see them too
+			}
+			b = findBuiltin(c->name);
+			if (b != NULL) { // built in command, runs inside the shell
+				quit = runBuiltin(b, c, status);
+				while ((coprocJob = coprocTake()) != -1) { // coproc started a background job
+					statStart(coprocJob, c);
+					head = addPid(head, coprocJob, 0);
+				}
+				if (b->func == &builtInCD) {
+					cacheFlush(); // relative paths in the cache now point elsewhere
+				}
+				if (b->setsStatus) {
+					outcome = status;
+				}
+			}
+			else if (isAssignment(c)) {
+				// only sets variables, the status of the last foreground command is kept
+			}
+			else if ((c->background == 0 || fgOnly == 1) && fastCopy(c, status)) {
+				outcome = status; // plain copy, done inside the shell without forking
 			}
 			else if (c->background == 0 || fgOnly == 1) { // run in foreground
 				status = foreground(c, status);
+				outcome = status;
 
 			}
 			else { // run in background
-				struct pid* newPid = malloc(sizeof(struct pid));
-				newPid->num = background(c);
+				pid_t helpers[SUB_NUM + 1];
+				int helperNum;
+				pid_t newPid = background(c, helpers, &helperNum);
 
 				// add to or create linked list of pids
-				if (head == NULL) {
-					head = newPid;
+				if (newPid != -1) {
+					head = addPid(head, newPid, 0);
 				}
-				else {
-					tail->next = newPid;
+				for (int i = 0; i < helperNum; i++) {
+					head = addPid(head, helpers[i], 1);
 				}
-				tail = newPid;
+				outcome = "background";
+			}
+			if (c->name[0] != '\0' && c->assignNum > 0) {
+				varPop();
+			}
+			if (record != NULL) {
+				recordCommand(record, started - recordStart, nowMicros() - started, outcome, line, hereDoc ? c->hereBody : NULL);
 			}
 			freeCommand(c);
+			if (quit) {
+				free(status);
+				return 0;
+			}
 		}
 
 		commandLine[0] = '\0'; // clear previous command line
@@ -556,14 +1325,106 @@ int getCommand() {
 *
 *  main
 * -------------
-*  Just here for moral support.
+*  Just here for moral support. Also reads the options for recording
+*  and replaying, and the script to run if one is given:
+*		FILE		run the commands in FILE instead of reading them
+*					from stdin, keeping redirected files open
+*		-r FILE		record each command line and its outcome to FILE
+*		-p FILE		replay FILE instead of reading commands
+*		-s SPEED	replay SPEED times faster than recorded, or "max"
+*		-j JOBS		run at most JOBS replayed commands at once
+*		-m			publish the job table in /dev/shm for smalltop
+*		-z LEVEL	compress >z redirections at LEVEL, 1 to 9
 *
 * -------------
 *
-*  Returns 0 on exit.
+*  Returns 0 on exit, or 1 if the options are wrong or a replay did
+*  not match its recording.
 * 
 *---------------------------------------------------------------------*/
-int main() {
-	getCommand();
+int main(int argc, char* argv[]) {
+	FILE* input = stdin;
+	FILE* record = NULL;
+	char* replay = NULL;
+	double speed = 1;
+	int jobs = 64; // enough that a recording with a few long commands still replays open-loop
+	char* end;
+	int opt;
+
+	shellPid = getpid();
+	varsInit(environ);
+	dagSpawn = &spawnAttached;
+
+	while ((opt = getopt(argc, argv, "r:p:s:j:mz:")) != -1) {
+		switch (opt) {
+		case 'r':
+			record = startRecord(optarg);
+			if (record == NULL) {
+				return 1;
+			}
+			break;
+		case 'p':
+			replay = optarg;
+			break;
+		case 's':
+			if (strcmp(optarg, "max") == 0) {
+				speed = 0;
+				break;
+			}
+			speed = strtod(optarg, &end);
+			if (end == optarg || *end != '\0' || !(speed > 0)) { // 0 would quietly mean max, NaN fails too
+				fprintf(stderr, "%s: speed must be a positive number or max\n", argv[0]);
+				return 1;
+			}
+			break;
+		case 'j':
+			jobs = atoi(optarg);
+			break;
+		case 'm':
+			if (statOpen() != 0) {
+				return 1;
+			}
+			break;
+		case 'z':
+			gzLevel = atoi(optarg);
+			if (gzLevel < 1 || gzLevel > 9) {
+				fprintf(stderr, "%s: compression level must be 1 to 9\n", argv[0]);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-m] [-z LEVEL] [-r FILE] [-p FILE [-s SPEED|max] [-j JOBS]] [SCRIPT]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (jobs < 1) {
+		fprintf(stderr, "%s: jobs must be at least 1\n", argv[0]);
+		return 1;
+	}
+
+	if (replay != NULL) {
+		opt = runReplay(replay, speed, jobs, &spawnBackground);
+		statClose();
+		return opt;
+	}
+
+	if (optind < argc) { // script mode
+		input = fopen(argv[optind], "re");
+		if (input == NULL) {
+			perror(argv[optind]);
+			return 1;
+		}
+		cacheOpen();
+	}
+
+	getCommand(input, record);
+	coprocCloseAll();
+	if (input != stdin) {
+		fclose(input);
+	}
+	if (record != NULL) {
+		fclose(record);
+	}
+	statClose();
 	return 0;
 }
\ No newline at end of file
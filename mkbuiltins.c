@@ -0,0 +1,129 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This is a build tool that makes builtin_table.h, the perfect hash table of the built in
+* commands listed in builtins.def. It searches for the smallest table and a seed for hashName()
+* that put every name in its own slot, so looking up a command in the shell takes one hash and
+* one string comparison. The makefile runs it whenever builtins.def changes.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "builtin.h"
+
+
+#define MAX_SEED 1000000 // seeds tried per table size before trying a bigger table
+
+
+char* names[] = {
+#define BUILTIN(name, func) #name,
+#define STATUS_BUILTIN(name, func) #name,
+#include "builtins.def"
+#undef BUILTIN
+#undef STATUS_BUILTIN
+};
+
+char* funcs[] = {
+#define BUILTIN(name, func) #func,
+#define STATUS_BUILTIN(name, func) #func,
+#include "builtins.def"
+#undef BUILTIN
+#undef STATUS_BUILTIN
+};
+
+int statuses[] = { // 1 if the return value becomes the shell's status
+#define BUILTIN(name, func) 0,
+#define STATUS_BUILTIN(name, func) 1,
+#include "builtins.def"
+#undef BUILTIN
+#undef STATUS_BUILTIN
+};
+
+
+/*----------------------------------------------------------------------
+*
+*  fits
+* -------------
+*  Checks if a seed puts every name in its own slot of a table.
+*
+* -------------
+*
+*  seed: an unsigned int to try with hashName()
+*
+*  slots: an unsigned int that is the size of the table, a power of 2
+*
+*  used: an array of slots ints used as scratch space
+*
+*  Returns 1 if there are no collisions, 0 otherwise.
+*
+*---------------------------------------------------------------------*/
+int fits(unsigned int seed, unsigned int slots, int* used) {
+	int num = sizeof(names) / sizeof(names[0]);
+	int i;
+
+	memset(used, 0, slots * sizeof(int));
+	for (i = 0; i < num; i++) {
+		unsigned int slot = hashName(names[i], seed) & (slots - 1);
+		if (used[slot]) {
+			return 0;
+		}
+		used[slot] = 1;
+	}
+	return 1;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  main
+* -------------
+*  Finds a table size and seed with no collisions and prints the table
+*  as a header file.
+*
+* -------------
+*
+*  Returns 0 if successful, returns 1 if no table could be made.
+*
+*---------------------------------------------------------------------*/
+int main() {
+	int num = sizeof(names) / sizeof(names[0]);
+	unsigned int slots = 1;
+	unsigned int seed;
+	int* used;
+	int i;
+
+	while (slots < (unsigned int)num) {
+		slots *= 2;
+	}
+
+	for (; slots <= 4096; slots *= 2) {
+		used = malloc(slots * sizeof(int));
+		for (seed = 0; seed < MAX_SEED; seed++) {
+			if (fits(seed, slots, used)) {
+				break;
+			}
+		}
+		free(used);
+		if (seed < MAX_SEED) {
+			break;
+		}
+	}
+	if (slots > 4096) {
+		fprintf(stderr, "mkbuiltins: no perfect hash found\n");
+		return 1;
+	}
+
+	printf("/*\n* Generated by mkbuiltins from builtins.def - do not edit.\n*/\n\n");
+	printf("#define BUILTIN_SEED %uu\n", seed);
+	printf("#define BUILTIN_SLOTS %u\n\n", slots);
+	printf("struct builtin builtinTable[BUILTIN_SLOTS] = {\n");
+	for (i = 0; i < num; i++) {
+		printf("\t[%u] = { \"%s\", &%s, %d },\n", hashName(names[i], seed) & (slots - 1), names[i], funcs[i], statuses[i]);
+	}
+	printf("};\n");
+
+	return 0;
+}
@@ -0,0 +1,273 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for the output relay, which copies the output of a command to
+* several files at once. The command writes to a pipe, and a single relay process per job
+* duplicates the pipe contents into every output file with tee() and splice().
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+
+#include "coproc.h"
+#include "relay.h"
+
+
+/*----------------------------------------------------------------------
+*
+*  runRelay
+* -------------
+*  Copies everything read from a pipe to each of the given files until
+*  the write end of the pipe is closed.
+*
+*  Each target has its own pipe that is filled with tee() and emptied
+*  into the file with splice(). Data is only removed from the source
+*  pipe once every target has a copy, so a slow target only holds up
+*  the others once its own pipe is full.
+*
+* -------------
+*
+*  source: an int that is the read end of the pipe the command writes
+*			its output to
+*
+*  targets: an array of ints that are open file descriptors for each
+*			of the output files
+*
+*  num: an int that is the number of targets
+*
+*  Returns 0 once all output has been written, returns 1 if any of the
+*  targets could not be written to.
+*
+*---------------------------------------------------------------------*/
+int runRelay(int source, int* targets, int num) {
+	int sinks[OUT_NUM][2]; // pipe between the source and each target
+	size_t ahead[OUT_NUM]; // bytes a target already holds past the start of the source
+	int full[OUT_NUM]; // 1 if the target's pipe had no room on the last tee()
+	int dead[OUT_NUM]; // 1 if the target could not be written to
+	int copy[OUT_NUM]; // 1 if the target does not accept splice(), such as files opened with O_APPEND
+	char buffer[65536]; // for targets that need to be written to the normal way
+	int index[OUT_NUM + 1]; // target that each pollfd belongs to, -1 for the source
+	struct pollfd fds[OUT_NUM + 1];
+	int devNull = open("/dev/null", O_WRONLY);
+	int eof = 0;
+	int result = 0;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		if (pipe2(sinks[i], O_NONBLOCK) == -1) {
+			perror("relay pipe()");
+			return 1;
+		}
+		fcntl(sinks[i][1], F_SETPIPE_SZ, RELAY_PIPE_SZ); // best effort, default size still works
+		ahead[i] = 0;
+		full[i] = 0;
+		dead[i] = 0;
+		copy[i] = 0;
+	}
+
+	while (1) {
+		int nfds = 0;
+		int blocked = 0;
+		int pending;
+
+		for (i = 0; i < num; i++) {
+			if (full[i] && !dead[i]) {
+				blocked = 1;
+			}
+		}
+
+		// only read more once every target has room, otherwise poll() would spin
+		if (!eof && !blocked) {
+			fds[nfds].fd = source;
+			fds[nfds].events = POLLIN;
+			index[nfds++] = -1;
+		}
+		for (i = 0; i < num; i++) {
+			if (!dead[i] && ioctl(sinks[i][0], FIONREAD, &pending) == 0 && pending > 0) {
+				fds[nfds].fd = targets[i];
+				fds[nfds].events = POLLOUT;
+				index[nfds++] = i;
+			}
+		}
+		if (nfds == 0) { // source is closed and every target is drained
+			break;
+		}
+
+		if (poll(fds, nfds, -1) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("relay poll()");
+			return 1;
+		}
+
+		for (int f = 0; f < nfds; f++) {
+			if (fds[f].revents == 0) {
+				continue;
+			}
+
+			if (index[f] == -1) { // new output from the command
+				size_t consume;
+				ssize_t n;
+
+				if (ioctl(source, FIONREAD, &pending) == -1 || pending == 0) {
+					eof = 1; // woken with nothing to read means the writer hung up
+					continue;
+				}
+
+				// copy to every target that is caught up, then drop what all of them have
+				consume = pending;
+				for (i = 0; i < num; i++) {
+					if (dead[i]) {
+						continue;
+					}
+					if (ahead[i] == 0) {
+						n = tee(source, sinks[i][1], pending, SPLICE_F_NONBLOCK);
+						if (n == -1) {
+							n = 0;
+							full[i] = 1;
+						}
+						ahead[i] = n;
+					}
+					if (ahead[i] < consume) {
+						consume = ahead[i];
+					}
+				}
+
+				for (i = 0; i < num; i++) {
+					if (!dead[i]) {
+						ahead[i] -= consume;
+					}
+				}
+				while (consume > 0) {
+					n = splice(source, NULL, devNull, NULL, consume, 0);
+					if (n <= 0) {
+						break;
+					}
+					consume -= n;
+				}
+			}
+			else { // a target is ready for more
+				i = index[f];
+				if (ioctl(sinks[i][0], FIONREAD, &pending) == -1) {
+					continue;
+				}
+				if (!copy[i] && splice(sinks[i][0], NULL, targets[i], NULL, pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK) == -1) {
+					if (errno == EAGAIN) {
+						continue;
+					}
+					if (errno == EINVAL) {
+						copy[i] = 1; // fall back to read() and write() for this target from now on
+					}
+					else {
+						perror("relay splice()");
+						dead[i] = 1;
+						result = 1;
+					}
+				}
+				if (copy[i]) {
+					ssize_t n = read(sinks[i][0], buffer, sizeof(buffer));
+					if (n > 0 && write(targets[i], buffer, n) != n) {
+						perror("relay write()");
+						dead[i] = 1;
+						result = 1;
+					}
+				}
+				full[i] = 0;
+			}
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		close(sinks[i][0]);
+		close(sinks[i][1]);
+	}
+	close(devNull);
+
+	return result;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  startRelay
+* -------------
+*  Opens every output file of a command and forks a relay process that
+*  copies the command output to all of them.
+*
+* -------------
+*
+*  c: a command struct that has more than one output file
+*
+*  writeFD: a pointer to an int that is set to the write end of the
+*			pipe that the command should use as its stdout
+*
+*  Returns the PID of the relay process, returns -1 and prints a
+*  message with the error if an output file cannot be opened.
+*
+*---------------------------------------------------------------------*/
+pid_t startRelay(struct command* c, int* writeFD) {
+	int targets[OUT_NUM];
+	int relayPipe[2];
+	pid_t relayPid;
+	int i;
+
+	for (i = 0; i < c->outNum; i++) {
+		int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (c->append[i] ? O_APPEND : O_TRUNC);
+		targets[i] = open(c->output[i], flags, 0640);
+		if (targets[i] == -1) {
+			perror("output open()");
+			while (i > 0) {
+				close(targets[--i]);
+			}
+			return -1;
+		}
+	}
+
+	if (pipe2(relayPipe, O_CLOEXEC) == -1) {
+		perror("relay pipe()");
+		for (i = 0; i < c->outNum; i++) {
+			close(targets[i]);
+		}
+		return -1;
+	}
+
+	fflush(stdout);
+	relayPid = fork();
+
+	switch (relayPid) {
+	case -1:
+		perror("fork()\n");
+		exit(1);
+		break;
+
+	case 0: // relay
+		signal(SIGTSTP, SIG_IGN);
+		signal(SIGPIPE, SIG_IGN); // report a closed target instead of dying
+		close(relayPipe[1]);
+		coprocCloseFds();
+		_exit(runRelay(relayPipe[0], targets, c->outNum));
+		break;
+
+	default: // parent
+		close(relayPipe[0]);
+		for (i = 0; i < c->outNum; i++) {
+			close(targets[i]);
+		}
+		*writeFD = relayPipe[1];
+		return relayPid;
+
+	}
+
+	return -1;
+}
@@ -0,0 +1,69 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for the output relay, which copies the output of a command
+* to several files at once using tee() and splice() so the data never passes through user space.
+*/
+
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <sys/types.h>
+
+#include "command.h"
+
+
+#define RELAY_PIPE_SZ 1048576 // size of the per-target pipes, lets fast targets run ahead of slow ones
+
+
+/*----------------------------------------------------------------------
+*
+*  runRelay
+* -------------
+*  Copies everything read from a pipe to each of the given files until
+*  the write end of the pipe is closed.
+*
+*  Each target has its own pipe that is filled with tee() and emptied
+*  into the file with splice(). Data is only removed from the source
+*  pipe once every target has a copy, so a slow target only holds up
+*  the others once its own pipe is full.
+*
+* -------------
+*
+*  source: an int that is the read end of the pipe the command writes
+*			its output to
+*
+*  targets: an array of ints that are open file descriptors for each
+*			of the output files
+*
+*  num: an int that is the number of targets
+*
+*  Returns 0 once all output has been written, returns 1 if any of the
+*  targets could not be written to.
+*
+*---------------------------------------------------------------------*/
+int runRelay(int source, int* targets, int num);
+
+
+/*----------------------------------------------------------------------
+*
+*  startRelay
+* -------------
+*  Opens every output file of a command and forks a relay process that
+*  copies the command output to all of them.
+*
+* -------------
+*
+*  c: a command struct that has more than one output file
+*
+*  writeFD: a pointer to an int that is set to the write end of the
+*			pipe that the command should use as its stdout
+*
+*  Returns the PID of the relay process, returns -1 and prints a
+*  message with the error if an output file cannot be opened.
+*
+*---------------------------------------------------------------------*/
+pid_t startRelay(struct command* c, int* writeFD);
+
+#endif
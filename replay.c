@@ -0,0 +1,546 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for recording the command lines run by the shell to a log, and for
+* replaying a log as an open-loop load generator. A replay starts each command at its recorded
+* time (optionally sped up), reaps them as they finish, and reports throughput, latency
+* percentiles, and any commands whose exit status differs from the recording.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/pidfd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "builtin.h"
+#include "fastcopy.h"
+#include "replay.h"
+#include "vars.h"
+
+
+/*----------------------------------------------------------------------
+*
+*  struct entry
+* -------------
+*  Contains one command from a recorded log and what happened to it
+*  when it was replayed.
+*
+* -------------
+*
+*  start: a long that is when the command started, in microseconds
+*			since the recording started
+*
+*  outcome: a string (char*) that is the recorded status
+*
+*  line: a string (char*) that is the command line
+*
+*  body: a string (char*) that is the here-document body, or NULL
+*
+*  pid: a pid_t that is the PID of the replayed command while it runs
+*
+*  pidfd: an int that is a file descriptor for the running command
+*			that becomes readable when it exits
+*
+*  spawned: a long that is when the replayed command was started, in
+*			microseconds
+*
+*---------------------------------------------------------------------*/
+struct entry {
+	long start;
+	char* outcome;
+	char* line;
+	char* body;
+	pid_t pid;
+	int pidfd;
+	long spawned;
+};
+
+
+/*----------------------------------------------------------------------
+*
+*  nowMicros
+* -------------
+*  Gets the current time from the monotonic clock.
+*
+* -------------
+*
+*  Returns the current time in microseconds as a long.
+*
+*---------------------------------------------------------------------*/
+long nowMicros() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  writeEscaped
+* -------------
+*  Writes a string to a log with tabs, newlines and backslashes escaped.
+*
+* -------------
+*
+*  log: a FILE* for the log
+*
+*  text: a string (char*) to be written
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void writeEscaped(FILE* log, char* text) {
+	for (; *text != '\0'; text++) {
+		if (*text == '\t') {
+			fputs("\\t", log);
+		}
+		else if (*text == '\n') {
+			fputs("\\n", log);
+		}
+		else if (*text == '\\') {
+			fputs("\\\\", log);
+		}
+		else {
+			fputc(*text, log);
+		}
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  unescape
+* -------------
+*  Reverses writeEscaped() on a string in place.
+*
+* -------------
+*
+*  text: a string (char*) read from a log
+*
+*  Returns the same string with escapes replaced.
+*
+*---------------------------------------------------------------------*/
+char* unescape(char* text) {
+	char* from = text;
+	char* to = text;
+
+	while (*from != '\0') {
+		if (*from == '\\' && from[1] != '\0') {
+			from++;
+			*to++ = (*from == 't') ? '\t' : (*from == 'n') ? '\n' : *from;
+			from++;
+		}
+		else {
+			*to++ = *from++;
+		}
+	}
+	*to = '\0';
+	return text;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  startRecord
+* -------------
+*  Opens a log file for recording and writes the header line.
+*
+* -------------
+*
+*  path: a string (char*) that contains the location of the log file
+*
+*  Returns a FILE* for the log, or NULL and prints a message with the
+*  error if the file cannot be opened.
+*
+*---------------------------------------------------------------------*/
+FILE* startRecord(char* path) {
+	FILE* log = fopen(path, "w");
+
+	if (log == NULL) {
+		perror("record fopen()");
+		return NULL;
+	}
+	fprintf(log, "%s %ld\n", RECORD_HEADER, (long)time(NULL));
+	fflush(log);
+	return log;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  recordCommand
+* -------------
+*  Adds one command line and its outcome to a log.
+*
+*  Each entry is a line of tab separated fields: the start time and
+*  run time in microseconds, the outcome, the command line, and the
+*  here-document body if there is one. Tabs, newlines and backslashes
+*  in the text are escaped so an entry always fits on one line.
+*
+* -------------
+*
+*  log: a FILE* for the log, from startRecord()
+*
+*  start: a long that is the time the command started, in
+*			microseconds since the recording started
+*
+*  duration: a long that is how long the command took, in
+*			microseconds
+*
+*  outcome: a string (char*) that is the status of the command, such
+*			as "exit value 0", or "background" or "builtin"
+*
+*  line: a string (char*) that is the command line as it was read
+*
+*  body: a string (char*) that is the here-document body, or NULL
+*
+*  Returns nothing, but writes and flushes the entry.
+*
+*---------------------------------------------------------------------*/
+void recordCommand(FILE* log, long start, long duration, char* outcome, char* line, char* body) {
+	fprintf(log, "%ld\t%ld\t%s\t", start, duration, outcome);
+	writeEscaped(log, line);
+	if (body != NULL) {
+		fputc('\t', log);
+		writeEscaped(log, body);
+	}
+	fputc('\n', log);
+	fflush(log); // keep the log complete even if the shell is killed
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  loadRecord
+* -------------
+*  Reads every entry of a recorded log into an array.
+*
+* -------------
+*
+*  path: a string (char*) that contains the location of the log file
+*
+*  num: a pointer to an int that is set to the number of entries
+*
+*  Returns an array of entry structs, or NULL and prints a message
+*  with the error if the file cannot be read.
+*
+*---------------------------------------------------------------------*/
+struct entry* loadRecord(char* path, int* num) {
+	FILE* log = fopen(path, "r");
+	struct entry* entries;
+	int capacity = 64;
+	char* line = NULL;
+	size_t size = 0;
+
+	if (log == NULL) {
+		perror("replay fopen()");
+		return NULL;
+	}
+
+	entries = malloc(capacity * sizeof(struct entry));
+	*num = 0;
+	while (getline(&line, &size, log) != -1) {
+		char* saveptr;
+		char* start;
+		char* text;
+		struct entry* e;
+
+		if (line[0] == '#') { // header
+			continue;
+		}
+		line[strcspn(line, "\n")] = '\0';
+
+		start = strtok_r(line, "\t", &saveptr);
+		strtok_r(NULL, "\t", &saveptr); // recorded duration is not needed to replay
+		e = &entries[*num];
+		e->outcome = strtok_r(NULL, "\t", &saveptr);
+		text = strtok_r(NULL, "\t", &saveptr);
+		if (start == NULL || e->outcome == NULL || text == NULL) {
+			continue;
+		}
+		e->start = atol(start);
+		e->outcome = strdup(e->outcome);
+		e->line = strdup(unescape(text));
+		text = strtok_r(NULL, "\t", &saveptr);
+		e->body = (text != NULL) ? strdup(unescape(text)) : NULL;
+		e->pid = 0;
+		e->pidfd = -1;
+
+		if (++(*num) == capacity) {
+			capacity *= 2;
+			entries = realloc(entries, capacity * sizeof(struct entry));
+		}
+	}
+
+	free(line);
+	fclose(log);
+	return entries;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  compareLong
+* -------------
+*  Comparison function for sorting an array of longs with qsort().
+*
+* -------------
+*
+*  a: a pointer to the first long
+*
+*  b: a pointer to the second long
+*
+*  Returns a negative number, zero, or a positive number if the first
+*  long is less than, equal to, or greater than the second.
+*
+*---------------------------------------------------------------------*/
+int compareLong(const void* a, const void* b) {
+	long x = *(const long*)a;
+	long y = *(const long*)b;
+	return (x > y) - (x < y);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  percentile
+* -------------
+*  Finds a percentile of a sorted array using the nearest rank.
+*
+* -------------
+*
+*  sorted: an array of longs in increasing order
+*
+*  num: an int that is the length of the array, at least 1
+*
+*  p: a double between 0 and 100 that is the percentile to find
+*
+*  Returns the value at the given percentile.
+*
+*---------------------------------------------------------------------*/
+long percentile(long* sorted, int num, double p) {
+	int rank = (int)(p / 100.0 * num + 0.999999); // round up to the next rank
+	if (rank < 1) {
+		rank = 1;
+	}
+	if (rank > num) {
+		rank = num;
+	}
+	return sorted[rank - 1];
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  runReplay
+* -------------
+*  Replays a recorded log as an open-loop load generator. Commands are
+*  started at their recorded times, scaled by the speed, regardless of
+*  whether earlier commands have finished, with at most the given
+*  number running at once.
+*
+*  Prints a report with the throughput, the percentiles of the time
+*  from spawning each command to reaping it, and every command whose
+*  exit status differs from the recording.
+*
+* -------------
+*
+*  path: a string (char*) that contains the location of the log file
+*
+*  speed: a double that is how many times faster than recorded to
+*			replay, or 0 to start commands as fast as possible
+*
+*  jobs: an int that is the most commands allowed to run at once
+*
+*  spawn: a function that starts a command without waiting for it and
+*			returns its PID, filling an array with the PIDs of any
+*			helper processes and setting their count
+*
+*  Returns 0 if every command matched the recording, 1 if any diverged
+*  or the log could not be read.
+*
+*---------------------------------------------------------------------*/
+int runReplay(char* path, double speed, int jobs, pid_t (*spawn)(struct command*, pid_t*, int*)) {
+	struct entry* entries;
+	int num;
+	int next = 0; // next entry to start
+	int running = 0;
+	int done = 0;
+	int skipped = 0;
+	int diverged = 0;
+	int* slots; // entry running in each slot, or -1
+	struct pollfd* fds;
+	long* latencies;
+	long maxLag = 0; // furthest behind schedule a command was started
+	long begin;
+	long elapsed;
+	int i;
+
+	entries = loadRecord(path, &num);
+	if (entries == NULL) {
+		return 1;
+	}
+	latencies = malloc((num + 1) * sizeof(long));
+	slots = malloc(jobs * sizeof(int));
+	fds = malloc(jobs * sizeof(struct pollfd));
+	for (i = 0; i < jobs; i++) {
+		slots[i] = -1;
+	}
+
+	begin = nowMicros();
+	while (next < num || running > 0) {
+		long now = nowMicros();
+		long due = 0; // how long until the next entry should start
+		int nfds = 0;
+		pid_t childPid;
+		int childStatus;
+
+		// start every entry that is due, as long as there is a free slot
+		while (next < num && running < jobs) {
+			struct entry* e = &entries[next];
+			char line[MAX_LEN];
+			struct command* c;
+			char status[MAX_LEN];
+			pid_t helpers[SUB_NUM + 1];
+			int helperNum;
+
+			due = (speed > 0) ? begin + (long)(e->start / speed) - now : 0;
+			if (due > 0) {
+				break;
+			}
+			if (-due > maxLag) {
+				maxLag = -due;
+			}
+			next++;
+
+			strncpy(line, e->line, MAX_LEN - 1);
+			line[MAX_LEN - 1] = '\0';
+			c = parseCommand(line);
+			if (e->body != NULL) {
+				free(c->hereDelim);
+				c->hereDelim = NULL;
+				c->hereBody = strdup(e->body);
+			}
+			for (i = 0; c->name[0] == '\0' && i < c->assignNum; i++) {
+				varAssign(c->assign[i], 0); // no command, so they set shell variables
+			}
+
+			if (isAssignment(c)) {
+				skipped++;
+			}
+			else if (c->name[0] == '\0' && c->background == 0 && fastCopy(c, status)) { // only redirections, copied by the shell itself
+				if (strcmp(e->outcome, status) != 0) {
+					printf("diverged: %s (recorded %s, replayed %s)\n", e->line, e->outcome, status);
+					diverged++;
+				}
+				skipped++;
+			}
+			else if (strcmp(c->name, "cd") == 0) { // replayed in order so later paths still resolve
+				chdir(c->args[1] != NULL ? c->args[1] : getenv("HOME"));
+				skipped++;
+			}
+			else if (findBuiltin(c->name) != NULL) { // other built in commands only change the recording shell
+				skipped++;
+			}
+			else {
+				e->spawned = nowMicros();
+				e->pid = spawn(c, helpers, &helperNum); // helpers are reaped below with everything else
+				if (e->pid == -1) {
+					skipped++;
+				}
+				else {
+					e->pidfd = pidfd_open(e->pid, 0);
+					for (i = 0; slots[i] != -1; i++);
+					slots[i] = e - entries;
+					running++;
+				}
+			}
+			freeCommand(c);
+			now = nowMicros();
+		}
+
+		// sleep until a command exits or the next entry is due
+		for (i = 0; i < jobs; i++) {
+			if (slots[i] != -1 && entries[slots[i]].pidfd != -1) {
+				fds[nfds].fd = entries[slots[i]].pidfd;
+				fds[nfds++].events = POLLIN;
+			}
+		}
+		if (nfds > 0 || due > 0) {
+			long wait = (next < num && running < jobs) ? due : -1;
+			poll(fds, nfds, (wait == -1) ? 1000 : (int)((wait + 999) / 1000));
+		}
+
+		while ((childPid = waitpid(-1, &childStatus, WNOHANG)) > 0) {
+			char status[64];
+			struct entry* e = NULL;
+
+			for (i = 0; i < jobs; i++) {
+				if (slots[i] != -1 && entries[slots[i]].pid == childPid) {
+					e = &entries[slots[i]];
+					slots[i] = -1;
+					break;
+				}
+			}
+			if (e == NULL) { // a helper process
+				continue;
+			}
+
+			latencies[done++] = nowMicros() - e->spawned;
+			if (e->pidfd != -1) {
+				close(e->pidfd);
+			}
+			running--;
+
+			if (WIFEXITED(childStatus)) {
+				sprintf(status, "exit value %d", WEXITSTATUS(childStatus));
+			}
+			else {
+				sprintf(status, "terminated by signal %d", WTERMSIG(childStatus));
+			}
+
+			// background commands were not waited for, so they have nothing to compare against
+			if (strcmp(e->outcome, "background") != 0 && strcmp(e->outcome, status) != 0) {
+				printf("diverged: %s (recorded %s, replayed %s)\n", e->line, e->outcome, status);
+				diverged++;
+			}
+		}
+	}
+	elapsed = nowMicros() - begin;
+	while (waitpid(-1, NULL, 0) > 0); // helpers still finishing up
+
+	printf("replayed %d commands (%d skipped) in %.3f s, %.1f commands/s\n", done, skipped,
+		elapsed / 1e6, elapsed > 0 ? done / (elapsed / 1e6) : 0.0);
+	if (done > 0) {
+		qsort(latencies, done, sizeof(long), compareLong);
+		printf("spawn to exit: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+			percentile(latencies, done, 50) / 1e3, percentile(latencies, done, 90) / 1e3,
+			percentile(latencies, done, 99) / 1e3, latencies[done - 1] / 1e3);
+	}
+	if (speed > 0) {
+		printf("furthest behind schedule: %.3f ms\n", maxLag / 1e3);
+	}
+	printf("%d diverged from the recording\n", diverged);
+	fflush(stdout);
+
+	for (i = 0; i < num; i++) {
+		free(entries[i].outcome);
+		free(entries[i].line);
+		free(entries[i].body);
+	}
+	free(entries);
+	free(slots);
+	free(fds);
+	free(latencies);
+
+	return diverged > 0;
+}
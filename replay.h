@@ -0,0 +1,118 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for recording the command lines run by the shell to a log
+* and replaying a log as a load generator, reporting throughput and latency of the commands.
+*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "command.h"
+
+
+#define RECORD_HEADER "# smallsh record" // first line of every log
+
+
+/*----------------------------------------------------------------------
+*
+*  nowMicros
+* -------------
+*  Gets the current time from the monotonic clock.
+*
+* -------------
+*
+*  Returns the current time in microseconds as a long.
+*
+*---------------------------------------------------------------------*/
+long nowMicros();
+
+
+/*----------------------------------------------------------------------
+*
+*  startRecord
+* -------------
+*  Opens a log file for recording and writes the header line.
+*
+* -------------
+*
+*  path: a string (char*) that contains the location of the log file
+*
+*  Returns a FILE* for the log, or NULL and prints a message with the
+*  error if the file cannot be opened.
+*
+*---------------------------------------------------------------------*/
+FILE* startRecord(char* path);
+
+
+/*----------------------------------------------------------------------
+*
+*  recordCommand
+* -------------
+*  Adds one command line and its outcome to a log.
+*
+*  Each entry is a line of tab separated fields: the start time and
+*  run time in microseconds, the outcome, the command line, and the
+*  here-document body if there is one. Tabs, newlines and backslashes
+*  in the text are escaped so an entry always fits on one line.
+*
+* -------------
+*
+*  log: a FILE* for the log, from startRecord()
+*
+*  start: a long that is the time the command started, in
+*			microseconds since the recording started
+*
+*  duration: a long that is how long the command took, in
+*			microseconds
+*
+*  outcome: a string (char*) that is the status of the command, such
+*			as "exit value 0", or "background" or "builtin"
+*
+*  line: a string (char*) that is the command line as it was read
+*
+*  body: a string (char*) that is the here-document body, or NULL
+*
+*  Returns nothing, but writes and flushes the entry.
+*
+*---------------------------------------------------------------------*/
+void recordCommand(FILE* log, long start, long duration, char* outcome, char* line, char* body);
+
+
+/*----------------------------------------------------------------------
+*
+*  runReplay
+* -------------
+*  Replays a recorded log as an open-loop load generator. Commands are
+*  started at their recorded times, scaled by the speed, regardless of
+*  whether earlier commands have finished, with at most the given
+*  number running at once.
+*
+*  Prints a report with the throughput, the percentiles of the time
+*  from spawning each command to reaping it, and every command whose
+*  exit status differs from the recording.
+*
+* -------------
+*
+*  path: a string (char*) that contains the location of the log file
+*
+*  speed: a double that is how many times faster than recorded to
+*			replay, or 0 to start commands as fast as possible
+*
+*  jobs: an int that is the most commands allowed to run at once
+*
+*  spawn: a function that starts a command without waiting for it and
+*			returns its PID, filling an array with the PIDs of any
+*			helper processes and setting their count
+*
+*  Returns 0 if every command matched the recording, 1 if any diverged
+*  or the log could not be read.
+*
+*---------------------------------------------------------------------*/
+int runReplay(char* path, double speed, int jobs, pid_t (*spawn)(struct command*, pid_t*, int*));
+
+#endif
@@ -0,0 +1,258 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This is a monitor for smallsh, similar to top. Every shell started with -m publishes its job
+* table in /dev/shm, and this program maps each of those files read-only and prints what every
+* shell of the user is running. Tables are copied using the sequence lock described in
+* jobstat.h, so reading them never makes a shell wait.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "jobstat.h"
+
+
+/*----------------------------------------------------------------------
+*
+*  readTable
+* -------------
+*  Copies a consistent snapshot of a shell's job table.
+*
+* -------------
+*
+*  shared: a pointer to the mapped statTable struct of a shell
+*
+*  copy: a pointer to a statTable struct that the snapshot is copied to
+*
+*  Returns 0 if successful, returns 1 if the shell kept changing the
+*  table or it is not a job table.
+*
+*---------------------------------------------------------------------*/
+int readTable(struct statTable* shared, struct statTable* copy) {
+	uint32_t before;
+	uint32_t after;
+	int tries;
+
+	if (__atomic_load_n(&shared->magic, __ATOMIC_ACQUIRE) != STAT_MAGIC || shared->version != STAT_VERSION) {
+		return 1;
+	}
+
+	for (tries = 0; tries < 1000; tries++) {
+		before = __atomic_load_n(&shared->seq, __ATOMIC_ACQUIRE);
+		if (before & 1) { // shell is in the middle of a change
+			continue;
+		}
+		memcpy(copy, shared, sizeof(struct statTable));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE); // finish copying before checking the counter again
+		after = __atomic_load_n(&shared->seq, __ATOMIC_RELAXED);
+		if (before == after) {
+			copy->spawnFailures = __atomic_load_n(&shared->spawnFailures, __ATOMIC_RELAXED);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  formatTime
+* -------------
+*  Formats a length of time as hours, minutes and seconds.
+*
+* -------------
+*
+*  micros: an int64_t that is the length of time in microseconds
+*
+*  buffer: a string (char*) of at least 16 characters for the result
+*
+*  Returns the buffer.
+*
+*---------------------------------------------------------------------*/
+char* formatTime(int64_t micros, char* buffer) {
+	long seconds = (micros > 0) ? micros / 1000000 : 0;
+	sprintf(buffer, "%02ld:%02ld:%02ld", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+	return buffer;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  printShell
+* -------------
+*  Prints the counters and job table of one shell.
+*
+* -------------
+*
+*  t: a pointer to a snapshot of the shell's statTable struct
+*
+*  now: an int64_t that is the current time in microseconds since the
+*		epoch
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void printShell(struct statTable* t, int64_t now) {
+	char elapsed[32];
+	char status[64];
+	int i;
+
+	printf("smallsh %d  up %s  commands %lld  spawn failures %lld  last: %s\n", t->shellPid,
+		formatTime(now - t->started, elapsed), (long long)t->commands, (long long)t->spawnFailures, t->lastStatus);
+	printf("  %8s  %-5s  %-8s  %-24s  %s\n", "PID", "STATE", "TIME", "STATUS", "COMMAND");
+
+	for (i = 0; i < STAT_JOBS; i++) {
+		struct statJob* job = &t->jobs[i];
+		if (job->state == JOB_FREE) {
+			continue;
+		}
+
+		status[0] = '\0';
+		if (job->state == JOB_DONE) {
+			if (WIFEXITED(job->status)) {
+				sprintf(status, "exit value %d", WEXITSTATUS(job->status));
+			}
+			else {
+				sprintf(status, "terminated by signal %d", WTERMSIG(job->status));
+			}
+		}
+		printf("  %8d  %-5s  %-8s  %-24s  %s%s\n", job->pid, (job->state == JOB_RUNNING) ? "run" : "done",
+			formatTime(((job->state == JOB_RUNNING) ? now : job->end) - job->start, elapsed), status,
+			job->command, job->background ? " &" : "");
+	}
+	printf("\n");
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  printAll
+* -------------
+*  Finds the job table of every smallsh of the user and prints them.
+*  Tables of other users' shells cannot be read and are skipped.
+*  Tables left behind by shells that are no longer running are skipped.
+*
+* -------------
+*
+*  Returns the number of shells printed.
+*
+*---------------------------------------------------------------------*/
+int printAll() {
+	DIR* dir = opendir(STAT_DIR);
+	struct dirent* ent;
+	struct statTable copy;
+	struct timespec clock;
+	int64_t now;
+	int shells = 0;
+
+	if (dir == NULL) {
+		perror("opendir()");
+		return 0;
+	}
+	clock_gettime(CLOCK_REALTIME, &clock);
+	now = clock.tv_sec * 1000000LL + clock.tv_nsec / 1000;
+
+	while ((ent = readdir(dir)) != NULL) {
+		char path[512];
+		struct statTable* shared;
+		struct stat info;
+		int fd;
+
+		if (strncmp(ent->d_name, STAT_PREFIX, strlen(STAT_PREFIX)) != 0) {
+			continue;
+		}
+		snprintf(path, sizeof(path), "%s/%s", STAT_DIR, ent->d_name);
+
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd == -1) {
+			continue;
+		}
+		if (fstat(fd, &info) == -1 || info.st_size < (off_t) sizeof(struct statTable)) { // shell is still sizing it, touching the missing part would be SIGBUS
+			close(fd);
+			continue;
+		}
+		shared = mmap(NULL, sizeof(struct statTable), PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (shared == MAP_FAILED) {
+			continue;
+		}
+
+		if (readTable(shared, &copy) == 0 && (kill(copy.shellPid, 0) == 0 || errno == EPERM)) {
+			printShell(&copy, now);
+			shells++;
+		}
+		munmap(shared, sizeof(struct statTable));
+	}
+
+	closedir(dir);
+	return shells;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  main
+* -------------
+*  Prints every shell's jobs, refreshing until interupted. Options:
+*		-d SECONDS	time between refreshes, 1 by default
+*		-n COUNT	stop after COUNT refreshes
+*
+* -------------
+*
+*  Returns 0 on exit, or 1 if the options are wrong.
+*
+*---------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+	double delay = 1;
+	int count = -1; // forever
+	int clear = isatty(STDOUT_FILENO);
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:n:")) != -1) {
+		switch (opt) {
+		case 'd':
+			delay = atof(optarg);
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-d SECONDS] [-n COUNT]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	while (count != 0) {
+		struct timespec pause;
+
+		if (clear) {
+			printf("\033[H\033[J"); // move to the top and clear the screen
+		}
+		if (printAll() == 0) {
+			printf("no smallsh is publishing its jobs (start one with smallsh -m)\n");
+		}
+		fflush(stdout);
+
+		if (count > 0 && --count == 0) {
+			break;
+		}
+		pause.tv_sec = (time_t)delay;
+		pause.tv_nsec = (long)((delay - pause.tv_sec) * 1e9);
+		nanosleep(&pause, NULL);
+	}
+
+	return 0;
+}
@@ -0,0 +1,541 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the code for shell variables and the built in commands that use them. Each
+* variable is stored as one "NAME=value" string, which is also what exec needs, so rebuilding the
+* exported environment only copies pointers.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h> // for isalpha() and isalnum()
+
+#include "builtin.h"
+#include "vars.h"
+
+
+/*----------------------------------------------------------------------
+*
+*  struct var
+* -------------
+*  Contains one shell variable, as a link in a chain of the hash table.
+*
+* -------------
+*
+*  entry: a string (char*) of the form NAME=value
+*
+*  nameLen: an int that is the length of NAME
+*
+*  exported: an int, 1 if the variable is passed to commands
+*
+*  next: a pointer to the next var struct in the same bucket
+*
+*---------------------------------------------------------------------*/
+struct var {
+	char* entry;
+	int nameLen;
+	int exported;
+	struct var* next;
+};
+
+
+struct var** buckets = NULL;
+int bucketNum = 0;
+int varNum = 0;
+
+char** envCache = NULL; // exported entries handed to exec
+int exportedNum = 0;
+int envStale = 1; // 1 when envCache no longer matches the exported variables
+
+char** pushedNames = NULL; // NAME=value words set by varPush(), undone by varPop()
+char** pushedOld = NULL; // entries they replaced, NULL where the variable was not set
+int* pushedExported = NULL;
+int pushedNum = 0;
+
+
+/*----------------------------------------------------------------------
+*
+*  hashVar
+* -------------
+*  Hashes a variable name with FNV-1a like hashName() in builtin.h,
+*  but over a length since names are looked up inside longer strings.
+*
+* -------------
+*
+*  name, len: see varGet()
+*
+*  Returns the hash.
+*
+*---------------------------------------------------------------------*/
+unsigned int hashVar(char* name, int len) {
+	unsigned int hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+	}
+	return hash;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  findVar
+* -------------
+*  Finds the link in the hash table that points to a variable.
+*
+* -------------
+*
+*  name, len: see varGet()
+*
+*  Returns a pointer to the pointer to the var struct, which points
+*  to NULL if the variable is not set.
+*
+*---------------------------------------------------------------------*/
+struct var** findVar(char* name, int len) {
+	struct var** link;
+
+	if (bucketNum == 0) {
+		bucketNum = VAR_BUCKETS;
+		buckets = calloc(bucketNum, sizeof(struct var*));
+	}
+
+	link = &buckets[hashVar(name, len) & (bucketNum - 1)];
+	while (*link != NULL && ((*link)->nameLen != len || strncmp((*link)->entry, name, len) != 0)) {
+		link = &(*link)->next;
+	}
+	return link;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  growTable
+* -------------
+*  Doubles the number of buckets and moves every variable over, so the
+*  chains stay short.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void growTable() {
+	struct var** old = buckets;
+	int oldNum = bucketNum;
+	struct var* curr;
+	struct var* next;
+	unsigned int slot;
+	int i;
+
+	bucketNum *= 2;
+	buckets = calloc(bucketNum, sizeof(struct var*));
+	for (i = 0; i < oldNum; i++) {
+		for (curr = old[i]; curr != NULL; curr = next) {
+			next = curr->next;
+			slot = hashVar(curr->entry, curr->nameLen) & (bucketNum - 1);
+			curr->next = buckets[slot];
+			buckets[slot] = curr;
+		}
+	}
+	free(old);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varsInit
+* -------------
+*  Fills the variable table with the environment the shell started
+*  with, all of it exported.
+*
+* -------------
+*
+*  env: an array of strings (char**) of the form NAME=value, ending
+*			with NULL
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varsInit(char** env) {
+	int i;
+
+	for (i = 0; env[i] != NULL; i++) {
+		if (varNameLen(env[i]) > 0 && env[i][varNameLen(env[i])] == '=') {
+			varAssign(env[i], 1);
+		}
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varNameLen
+* -------------
+*  Measures the variable name at the start of a string, letters,
+*  digits and underscores that do not start with a digit.
+*
+* -------------
+*
+*  string: a string (char*) that may start with a name
+*
+*  Returns the length of the name, 0 if the string does not start
+*  with one.
+*
+*---------------------------------------------------------------------*/
+int varNameLen(char* string) {
+	int len = 0;
+
+	if (!isalpha((unsigned char) string[0]) && string[0] != '_') {
+		return 0;
+	}
+	while (isalnum((unsigned char) string[len]) || string[len] == '_') {
+		len++;
+	}
+	return len;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varGet
+* -------------
+*  Looks up the value of a variable.
+*
+* -------------
+*
+*  name: a string (char*) that starts with the name
+*
+*  len: an int that is the length of the name
+*
+*  Returns the value, or NULL if the variable is not set.
+*
+*---------------------------------------------------------------------*/
+char* varGet(char* name, int len) {
+	struct var* found = *findVar(name, len);
+
+	return (found != NULL) ? found->entry + len + 1 : NULL;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varSet
+* -------------
+*  Sets a variable, adding it if it is new.
+*
+* -------------
+*
+*  name, len: see varGet()
+*
+*  value: a string (char*) that contains the new value
+*
+*  export: an int, 1 to export the variable, 0 to keep it exported
+*			or local as it was - new variables are local
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varSet(char* name, int len, char* value, int export) {
+	struct var** link = findVar(name, len);
+	struct var* found = *link;
+	char* entry = malloc(len + strlen(value) + 2);
+
+	sprintf(entry, "%.*s=%s", len, name, value);
+	if (found == NULL) {
+		found = calloc(1, sizeof(struct var));
+		found->nameLen = len;
+		*link = found;
+		varNum++;
+	}
+	else {
+		free(found->entry);
+	}
+	found->entry = entry;
+
+	if (export && !found->exported) {
+		found->exported = 1;
+		exportedNum++;
+	}
+	if (found->exported) {
+		envStale = 1;
+	}
+
+	if (len == 4 && strncmp(name, "PATH", 4) == 0) {
+		setenv("PATH", entry + len + 1, 1); // for execvpe() and tab completion
+	}
+	if (varNum > bucketNum) {
+		growTable();
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varAssign
+* -------------
+*  Sets a variable from a NAME=value word.
+*
+* -------------
+*
+*  assignment: a string (char*) of the form NAME=value
+*
+*  export: see varSet()
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varAssign(char* assignment, int export) {
+	int len = varNameLen(assignment);
+
+	varSet(assignment, len, assignment + len + 1, export);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varUnset
+* -------------
+*  Removes a variable if it is set.
+*
+* -------------
+*
+*  name, len: see varGet()
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varUnset(char* name, int len) {
+	struct var** link = findVar(name, len);
+	struct var* found = *link;
+
+	if (found == NULL) {
+		return;
+	}
+	*link = found->next;
+	if (found->exported) {
+		exportedNum--;
+		envStale = 1;
+	}
+	varNum--;
+	free(found->entry);
+	free(found);
+
+	if (len == 4 && strncmp(name, "PATH", 4) == 0) {
+		unsetenv("PATH");
+	}
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varPush
+* -------------
+*  Sets and exports the NAME=value words in front of a command that
+*  runs inside the shell, remembering what they replace so varPop()
+*  can put it back. Only one set is kept at a time.
+*
+* -------------
+*
+*  assign: an array of strings (char**) of the form NAME=value
+*
+*  num: an int that is the number of strings
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varPush(char** assign, int num) {
+	struct var* found;
+	int len;
+	int i;
+
+	pushedNames = realloc(pushedNames, num * sizeof(char*));
+	pushedOld = realloc(pushedOld, num * sizeof(char*));
+	pushedExported = realloc(pushedExported, num * sizeof(int));
+	for (i = 0; i < num; i++) {
+		len = varNameLen(assign[i]);
+		found = *findVar(assign[i], len);
+		pushedNames[i] = assign[i];
+		pushedOld[i] = (found != NULL) ? strdup(found->entry) : NULL;
+		pushedExported[i] = (found != NULL) ? found->exported : 0;
+		varAssign(assign[i], 1);
+	}
+	pushedNum = num;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varPop
+* -------------
+*  Undoes the last varPush(), restoring each variable to the value
+*  and export it had before, or removing it if it was not set.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varPop() {
+	struct var* found;
+	int len;
+	int i;
+
+	for (i = pushedNum - 1; i >= 0; i--) { // backwards, so a name given twice ends up as it started
+		len = varNameLen(pushedNames[i]);
+		if (pushedOld[i] == NULL) {
+			varUnset(pushedNames[i], len);
+			continue;
+		}
+		varAssign(pushedOld[i], 0);
+		found = *findVar(pushedNames[i], len);
+		if (found->exported != pushedExported[i]) {
+			found->exported = pushedExported[i];
+			exportedNum += found->exported ? 1 : -1;
+			envStale = 1;
+		}
+		free(pushedOld[i]);
+	}
+	pushedNum = 0;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  varEnviron
+* -------------
+*  Gets the environment to pass to exec. The array is rebuilt only if
+*  an exported variable changed since the last call.
+*
+* -------------
+*
+*  Returns an array of strings (char**) of the form NAME=value for
+*  every exported variable, ending with NULL. It belongs to the table
+*  and stays valid until the next change.
+*
+*---------------------------------------------------------------------*/
+char** varEnviron() {
+	struct var* curr;
+	int n = 0;
+	int i;
+
+	if (envStale) {
+		envCache = realloc(envCache, (exportedNum + 1) * sizeof(char*));
+		for (i = 0; i < bucketNum; i++) {
+			for (curr = buckets[i]; curr != NULL; curr = curr->next) {
+				if (curr->exported) {
+					envCache[n++] = curr->entry;
+				}
+			}
+		}
+		envCache[n] = NULL;
+		envStale = 0;
+	}
+	return envCache;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  compareEntries
+* -------------
+*  Compares two NAME=value strings for qsort().
+*
+* -------------
+*
+*  a, b: pointers to the strings (char**)
+*
+*  Returns the result of strcmp() on them.
+*
+*---------------------------------------------------------------------*/
+int compareEntries(const void* a, const void* b) {
+	return strcmp(*(char**) a, *(char**) b);
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInExport
+* -------------
+*  Code for the built in export command, "export [NAME[=value]...]",
+*  which exports variables, setting them first if a value is given.
+*  With no arguments it lists the exported variables.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if successful, returns 1 and prints a message if a name
+*  is not valid.
+*
+*---------------------------------------------------------------------*/
+int builtInExport(int argc, char* argv[], struct builtinIO* io) {
+	char** env;
+	char** sorted;
+	char* value;
+	int result = 0;
+	int len;
+	int i;
+
+	if (argc == 1) {
+		env = varEnviron();
+		sorted = malloc((exportedNum + 1) * sizeof(char*));
+		memcpy(sorted, env, (exportedNum + 1) * sizeof(char*));
+		qsort(sorted, exportedNum, sizeof(char*), &compareEntries);
+		for (i = 0; i < exportedNum; i++) {
+			dprintf(io->out, "export %s\n", sorted[i]);
+		}
+		free(sorted);
+		return 0;
+	}
+
+	for (i = 1; i < argc; i++) {
+		len = varNameLen(argv[i]);
+		if (len == 0 || (argv[i][len] != '=' && argv[i][len] != '\0')) {
+			dprintf(io->err, "export: %s: not a valid name\n", argv[i]);
+			result = 1;
+		}
+		else if (argv[i][len] == '=') {
+			varAssign(argv[i], 1);
+		}
+		else { // export as it is, or empty if it was never set
+			value = varGet(argv[i], len);
+			varSet(argv[i], len, (value != NULL) ? value : "", 1);
+		}
+	}
+	return result;
+}
+
+
+/*----------------------------------------------------------------------
+*
+*  builtInUnset
+* -------------
+*  Code for the built in unset command, "unset NAME...", which removes
+*  variables.
+*
+* -------------
+*
+*  argc, argv, io: see the loadable builtin ABI in builtin.h
+*
+*  Returns 0 if successful, returns 1 and prints a message if a name
+*  is not valid.
+*
+*---------------------------------------------------------------------*/
+int builtInUnset(int argc, char* argv[], struct builtinIO* io) {
+	int result = 0;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (varNameLen(argv[i]) != (int) strlen(argv[i])) {
+			dprintf(io->err, "unset: %s: not a valid name\n", argv[i]);
+			result = 1;
+		}
+		else {
+			varUnset(argv[i], strlen(argv[i]));
+		}
+	}
+	return result;
+}
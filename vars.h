@@ -0,0 +1,188 @@
+/*
+* Alexander Kim, kima4
+* CS344 - Assignment 3
+*
+* This file contains the header code for shell variables. Variables live in a hash table, so
+* looking one up for $NAME costs the same however many there are. Exported variables are passed
+* to the commands the shell runs; the array of them handed to exec is kept between commands and
+* only rebuilt after an exported variable changes. The environment the shell started with is
+* imported as exported variables.
+*
+*	NAME=value			sets a variable, local unless it is already exported
+*	NAME=value cmd		runs cmd with NAME exported to it, even a built in command, and then
+*						puts the shell's own back
+*	export NAME[=value]	exports a variable, or lists them all with no arguments
+*	unset NAME			removes a variable
+*
+* PATH is also kept in the shell's own environment, since execvpe() and tab completion search
+* the directories there.
+*/
+
+#ifndef VARS_H
+#define VARS_H
+
+
+#define VAR_BUCKETS 64 // starting size of the hash table, doubled whenever it fills up
+
+
+/*----------------------------------------------------------------------
+*
+*  varsInit
+* -------------
+*  Fills the variable table with the environment the shell started
+*  with, all of it exported.
+*
+* -------------
+*
+*  env: an array of strings (char**) of the form NAME=value, ending
+*			with NULL
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varsInit(char** env);
+
+
+/*----------------------------------------------------------------------
+*
+*  varNameLen
+* -------------
+*  Measures the variable name at the start of a string, letters,
+*  digits and underscores that do not start with a digit.
+*
+* -------------
+*
+*  string: a string (char*) that may start with a name
+*
+*  Returns the length of the name, 0 if the string does not start
+*  with one.
+*
+*---------------------------------------------------------------------*/
+int varNameLen(char* string);
+
+
+/*----------------------------------------------------------------------
+*
+*  varGet
+* -------------
+*  Looks up the value of a variable.
+*
+* -------------
+*
+*  name: a string (char*) that starts with the name
+*
+*  len: an int that is the length of the name
+*
+*  Returns the value, or NULL if the variable is not set.
+*
+*---------------------------------------------------------------------*/
+char* varGet(char* name, int len);
+
+
+/*----------------------------------------------------------------------
+*
+*  varSet
+* -------------
+*  Sets a variable, adding it if it is new.
+*
+* -------------
+*
+*  name, len: see varGet()
+*
+*  value: a string (char*) that contains the new value
+*
+*  export: an int, 1 to export the variable, 0 to keep it exported
+*			or local as it was - new variables are local
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varSet(char* name, int len, char* value, int export);
+
+
+/*----------------------------------------------------------------------
+*
+*  varAssign
+* -------------
+*  Sets a variable from a NAME=value word.
+*
+* -------------
+*
+*  assignment: a string (char*) of the form NAME=value
+*
+*  export: see varSet()
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varAssign(char* assignment, int export);
+
+
+/*----------------------------------------------------------------------
+*
+*  varUnset
+* -------------
+*  Removes a variable if it is set.
+*
+* -------------
+*
+*  name, len: see varGet()
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varUnset(char* name, int len);
+
+
+/*----------------------------------------------------------------------
+*
+*  varPush
+* -------------
+*  Sets and exports the NAME=value words in front of a command that
+*  runs inside the shell, remembering what they replace so varPop()
+*  can put it back. Only one set is kept at a time.
+*
+* -------------
+*
+*  assign: an array of strings (char**) of the form NAME=value
+*
+*  num: an int that is the number of strings
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varPush(char** assign, int num);
+
+
+/*----------------------------------------------------------------------
+*
+*  varPop
+* -------------
+*  Undoes the last varPush(), restoring each variable to the value
+*  and export it had before, or removing it if it was not set.
+*
+* -------------
+*
+*  Returns nothing.
+*
+*---------------------------------------------------------------------*/
+void varPop();
+
+
+/*----------------------------------------------------------------------
+*
+*  varEnviron
+* -------------
+*  Gets the environment to pass to exec. The array is rebuilt only if
+*  an exported variable changed since the last call.
+*
+* -------------
+*
+*  Returns an array of strings (char**) of the form NAME=value for
+*  every exported variable, ending with NULL. It belongs to the table
+*  and stays valid until the next change.
+*
+*---------------------------------------------------------------------*/
+char** varEnviron();
+
+#endif